@@ -4,7 +4,24 @@
 
 #ifndef PROJECT3_BST_H
 #define PROJECT3_BST_H
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <iterator>
 #include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <type_traits>
+#include <utility>
+#include "BSTBalance.h"
+#include "BSTStats.h"
+#include "NodePool.h"
+#include "ParallelSort.h"
+
 /**
  * @class BST - Binary Search Tree implementation of the Set ADT
  *
@@ -12,9 +29,19 @@
  * by the equality operator (operator==). There is no
  * concept in this class of multiple equivalent elements.
  *
+ * @tparam KeyType  element type, ordered by operator< and operator>
+ * @tparam Balance  balancing policy from BSTBalance.h; Unbalanced keeps the
+ *                  shape given by the insert order, AVLBalance keeps the
+ *                  height O(log n) for sorted or adversarial input,
+ *                  TreapBalance keeps it O(log n) expected with a shape
+ *                  that depends only on the keys
+ * @tparam Allocator  node allocation policy from NodePool.h; NodePool
+ *                    (the default) hands out nodes from contiguous chunks,
+ *                    NewDeleteAllocator uses one heap allocation per node
  */
 
-template<typename KeyType>
+template<typename KeyType, typename Balance = Unbalanced,
+        template<typename> class Allocator = NodePool>
 class BST {
 public:
     /**
@@ -41,20 +68,113 @@ public:
      */
     BST &operator=(const BST &rhs);
 
+    /**
+     * Move constructor takes over other's nodes; other is left empty.
+     * @param other another BST to move from
+     */
+    BST(BST &&other) noexcept;
+
+    /**
+     * Move assignment. Destroys current set and takes over rhs's nodes;
+     * rhs is left empty.
+     * @param rhs  another BST to move from
+     * @return *this
+     */
+    BST &operator=(BST &&rhs) noexcept;
+
     /**
      * Determine if the given key is currently in this set
      * @param key  possible element of this set
      * @return     true if key is an element, false otherwise
      */
-    bool has(KeyType key) const;
+    bool has(const KeyType &key) const;
+
+    /**
+     * Batched has(): results[i] = has(keys[i]) for i in [0, count).
+     * Up to LOOKUP_GROUP descents advance in lock step, one level each per
+     * round, and each prefetches its next node, so the cache misses of
+     * different keys overlap instead of stalling one after another.
+     * @param keys     keys to look up, in any order
+     * @param count    number of keys
+     * @param results  receives count answers
+     */
+    void hasMany(const KeyType *keys, size_t count, bool *results) const;
+
+    /**
+     * Batched has() for keys in ascending order: walks the tree once,
+     * splitting the batch at each node, so every node is visited at most
+     * once for the whole batch.
+     * @param keys     keys to look up, sorted ascending
+     * @param count    number of keys
+     * @param results  receives count answers
+     */
+    void hasManySorted(const KeyType *keys, size_t count, bool *results) const;
 
     /**
      * Insert a new element into the set.
      * If the element was already in the set, this method does nothing.
-     * @param newKey to insert
+     * @param newKey to insert, copied into the new node
      * @post has(newKey) is true
      */
-    void add(KeyType newKey);
+    void add(const KeyType &newKey);
+
+    /**
+     * Insert a new element into the set, moving it into the new node.
+     * If the element was already in the set, newKey is left untouched.
+     * @param newKey to insert
+     */
+    void add(KeyType &&newKey);
+
+    /**
+     * Insert an element constructed in place from args.
+     * The key is built directly inside a new node; if an equal element
+     * was already in the set, that node is discarded.
+     * @param args  constructor arguments for KeyType
+     */
+    template<typename... Args>
+    void emplace(Args &&... args);
+
+    /**
+     * Replace the contents of this set with the keys in [first, last),
+     * which must be strictly ascending (sorted, no duplicates). Builds a
+     * tree of minimum height in O(n) without any comparisons.
+     * @param first  start of the sorted keys
+     * @param last   end of the sorted keys
+     * @post         getInOrderTraversal() lists exactly [first, last)
+     */
+    template<typename ForwardIt>
+    void assignSorted(ForwardIt first, ForwardIt last);
+
+    /**
+     * assignSorted() on up to threads threads: the halves under each of
+     * the top log2(threads) nodes are built at the same time, each with
+     * its own allocator, which this tree then adopts.
+     * @param first    start of the sorted keys (random access)
+     * @param last     end of the sorted keys
+     * @param threads  how many threads may build at once
+     */
+    template<typename RandomIt>
+    void assignSorted(RandomIt first, RandomIt last, unsigned threads);
+
+    /**
+     * Replace the contents of this set with the keys in [first, last),
+     * in any order and possibly repeated. The keys are copied, sorted in
+     * parallel, deduplicated and handed to assignSorted(), using every
+     * hardware thread for PARALLEL_BUILD_CUTOFF keys or more and the
+     * calling thread below that. std::string_view keys for a
+     * BST<std::string> are sorted and deduplicated as views, so only the
+     * strings kept are allocated.
+     * @param first  start of the keys
+     * @param last   end of the keys
+     */
+    template<typename InputIt>
+    void buildFrom(InputIt first, InputIt last);
+
+    /**
+     * buildFrom() sorting and building on up to threads threads.
+     */
+    template<typename InputIt>
+    void buildFrom(InputIt first, InputIt last, unsigned threads);
 
     /**
      * Remove the given key from this set
@@ -64,65 +184,333 @@ public:
      * @param key  an element (possibly) of this set
      * @post       has(key) is false
      */
-    void remove(KeyType key);
+    void remove(const KeyType &key);
 
     /**
      * Check if this is an empty set.
      */
-    bool isEmpty();
+    bool isEmpty() const;
 
     /**
-     * Count the number of elements in this set. This must be implemented recursively
-     * and actually count the number of nodes (do not store the size in a data member).
+     * Count the number of elements in this set. O(1): every node keeps
+     * the size of its subtree.
      * @return the total node in the tree
      */
-    int size();
+    int size() const;
+
+    /**
+     * Count the elements strictly smaller than key. O(height).
+     * @param key  possible element of this set
+     * @return     number of elements less than key; equals key's
+     *             position in the in-order traversal if has(key)
+     */
+    int rank(const KeyType &key) const;
+
+    /**
+     * Find the i-th smallest element, counting from 0. O(height).
+     * @param i  position in the in-order traversal
+     * @return   the element at that position
+     * @throws std::out_of_range if i < 0 or i >= size()
+     */
+    const KeyType &select(int i) const;
+
+    /**
+     * Find the smallest element not less than key. O(height).
+     * @param key  bound, not necessarily an element
+     * @return     that element, or nullptr if every element is less
+     */
+    const KeyType *lowerBound(const KeyType &key) const;
+
+    /**
+     * Find the smallest element greater than key. O(height).
+     * @param key  bound, not necessarily an element
+     * @return     that element, or nullptr if none is greater
+     */
+    const KeyType *upperBound(const KeyType &key) const;
+
+    /**
+     * Count the elements in [lo, hi). O(height) whatever the size of the
+     * range: one descent to where the bounds part ways, then one down each
+     * side adding up the subtree counts in between.
+     * @param lo  inclusive lower bound
+     * @param hi  exclusive upper bound
+     * @return    0 if hi is not greater than lo
+     */
+    int countRange(const KeyType &lo, const KeyType &hi) const;
+
+    /**
+     * Calls visit(key) on every element in [lo, hi), in ascending order.
+     * Only the subtrees that can hold such elements are entered, so this
+     * is O(height + number visited).
+     * @param lo     inclusive lower bound
+     * @param hi     exclusive upper bound
+     * @param visit  callable taking const KeyType &
+     */
+    template<typename Visit>
+    void forEachInRange(const KeyType &lo, const KeyType &hi, Visit visit) const;
 
     /**
      * Count the number of leaves in this IntBST. Along with size(),
      * this should give some sense of the overall balance.
-     * Must use Node::isLeaf and must be implemented recursively.
+     * O(1): every node keeps the leaf count of its subtree.
      */
-    int getLeafCount();
+    int getLeafCount() const;
 
     /**
      * Returns height of the BST. The height is the number of levels it contains.
      * An empty BST has a height of 0. A BST with 1 element has the height of 1.
+     * O(1): every node keeps the height of its subtree.
      * @return height of the tree
      */
-    int getHeight();
+    int getHeight() const;
+
+    /**
+     * Internal path length: the sum of the depths of all elements, the
+     * root at depth 0. O(1): every node keeps it for its subtree.
+     * @return total depth, 0 for an empty or one-element tree
+     */
+    long long getPathLength() const;
+
+    /**
+     * Mean number of levels has() descends to find an element, the root
+     * counting as 1 (so a perfect tree of height h approaches h - 1). O(1).
+     * @return 1 + getPathLength() / size(), or 0 for an empty tree
+     */
+    double getAverageDepth() const;
+
+    /**
+     * Snapshot of this tree's operation counters (see BSTStats.h) and its
+     * current shape. Unless built with BST_STATS, only the shape (size,
+     * height, leaves, average depth) is filled in and enabled is false.
+     * @return the counts since construction or the last resetStats()
+     */
+    BSTStats stats() const;
+
+    /**
+     * Zero the operation counters; the tree itself is unchanged.
+     */
+    void resetStats();
 
     /**
      * Returns a string of elements in the order specified
-     * by the in-order traversal of the BST. Must use recursion.
+     * by the in-order traversal of the BST.
      * @return string of elements
      */
-    std::string getInOrderTraversal();
+    std::string getInOrderTraversal() const;
 
     /**
      * Returns a string of elements in the order specified by
-     * the pre-order traversal of the BST. Must use recursion.
+     * the pre-order traversal of the BST.
      * @return string of elements
      */
-    std::string getPreOrderTraversal();
+    std::string getPreOrderTraversal() const;
 
     /**
      * Returns a string of elements in the order specified by the
-     * post-order traversal of the BST. Must use recursion.
+     * post-order traversal of the BST.
      * @return string of elements
      */
-    std::string getPostOrderTraversal();
+    std::string getPostOrderTraversal() const;
+
+    /**
+     * Calls visit(key) on every element in in-order (ascending) order.
+     * Iterative, with a stack as deep as the tree; builds no strings.
+     * @param visit  callable taking const KeyType &
+     */
+    template<typename Visit>
+    void forEachInOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in pre-order order.
+     * @param visit  callable taking const KeyType &
+     */
+    template<typename Visit>
+    void forEachPreOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in post-order order.
+     * @param visit  callable taking const KeyType &
+     */
+    template<typename Visit>
+    void forEachPostOrder(Visit visit) const;
+
+    /**
+     * Split this set at key: the elements less than key stay, the others
+     * (key included, if an element) are returned as a new set. The tree is
+     * cut along one path in O(height) and both halves are rejoined with
+     * the balancing policy. A NodePool cannot be divided, so with a pooling
+     * allocator the returned half is copied into its own pool.
+     * @param key  first key of the returned half, not necessarily an element
+     * @return     the set of elements >= key
+     */
+    BST split(const KeyType &key);
+
+    /**
+     * Append every element of right, all of which must be greater than
+     * every element of this set, leaving right empty. O(height) plus
+     * taking over right's allocator.
+     * @param right  set to append
+     * @throws std::invalid_argument if the two sets overlap in key range
+     */
+    void join(BST &&right);
+
+    /**
+     * Make this set the union of itself and other. Join-based: other is
+     * split at my root's key, the halves are merged recursively (on up to
+     * hardware-concurrency threads for big trees) and rejoined, which is
+     * O(m log(n / m + 1)) work for sizes m <= n. Pass other as an rvalue
+     * to hand over its nodes instead of copying them.
+     * @param other  set to merge in
+     */
+    void unionWith(BST other);
+
+    /**
+     * unionWith() recursing on up to threads threads.
+     */
+    void unionWith(BST other, unsigned threads);
+
+    /**
+     * Keep only the elements that are also in other. Same scheme and cost
+     * as unionWith().
+     * @param other  set to intersect with
+     */
+    void intersectWith(BST other);
+
+    /**
+     * intersectWith() recursing on up to threads threads.
+     */
+    void intersectWith(BST other, unsigned threads);
+
+    /**
+     * Remove every element of other from this set. Same scheme and cost
+     * as unionWith().
+     * @param other  set of elements to remove
+     */
+    void differenceWith(BST other);
+
+    /**
+     * differenceWith() recursing on up to threads threads.
+     */
+    void differenceWith(BST other, unsigned threads);
 
 private:
+    /**
+     * Number of descents hasMany() keeps in flight.
+     */
+    static const size_t LOOKUP_GROUP = 16;
+
+    /**
+     * Subtrees smaller than this are built by the threaded assignSorted()
+     * on the calling thread, and buildFrom() does not start any threads
+     * for fewer keys.
+     */
+    static const int PARALLEL_BUILD_CUTOFF = 1 << 15;
+
+    /**
+     * What buildFrom() collects a Source key as before sorting: the
+     * std::string_view itself for BST<std::string>, which orders the same
+     * way, and KeyType for everything else.
+     */
+    template<typename Source>
+    using BuildKey = typename std::conditional<std::is_same<KeyType, std::string>::value
+                                               && std::is_same<Source, std::string_view>::value,
+            std::string_view, KeyType>::type;
+
+    /**
+     * buildFrom() once the keys are collected: sorts and deduplicates them,
+     * then builds the tree from them on up to threads threads.
+     */
+    template<typename Key>
+    void buildFromCollected(std::vector<Key> &keys, unsigned threads);
+
+    /**
+     * Set operations on fewer nodes than this (both trees together) are
+     * not split across threads.
+     */
+    static const int PARALLEL_SET_CUTOFF = 1 << 14;
+
+    enum class SetOp {
+        Union, Intersection, Difference
+    };
+
     struct Node {
         KeyType key;
+        int height;  // ahead of left so it fills the padding after small keys
         Node *left, *right;
+        int count;   // nodes in this subtree, me included
+        int leaves;  // leaves in this subtree
+        long long pathLength;  // sum of the depths below me, mine being 0
+
+        // Builds the key in place from args
+        template<typename... Args>
+        explicit Node(Args &&... args)
+                : key(std::forward<Args>(args)...), left(nullptr), right(nullptr) {
+            update();
+        }
+
+        /**
+         * Height of a possibly empty subtree.
+         * @param n  subtree root, may be nullptr
+         * @return   0 for an empty subtree, n->height otherwise
+         */
+        static int heightOf(const Node *n) {
+            return n == nullptr ? 0 : n->height;
+        }
+
+        /**
+         * Size of a possibly empty subtree.
+         * @param n  subtree root, may be nullptr
+         * @return   0 for an empty subtree, n->count otherwise
+         */
+        static int countOf(const Node *n) {
+            return n == nullptr ? 0 : n->count;
+        }
 
-        // Convenience constructor
-        Node(KeyType newKey, Node *lch = nullptr, Node *rch = nullptr) {
-            key = newKey;
-            left = lch;
-            right = rch;
+        /**
+         * Leaves of a possibly empty subtree.
+         * @param n  subtree root, may be nullptr
+         * @return   0 for an empty subtree, n->leaves otherwise
+         */
+        static int leavesOf(const Node *n) {
+            return n == nullptr ? 0 : n->leaves;
+        }
+
+        /**
+         * Internal path length of a possibly empty subtree.
+         * @param n  subtree root, may be nullptr
+         * @return   0 for an empty subtree, n->pathLength otherwise
+         */
+        static long long pathLengthOf(const Node *n) {
+            return n == nullptr ? 0 : n->pathLength;
+        }
+
+        /**
+         * std::hash of n's key, for policies that rank nodes by their
+         * keys (TreapBalance).
+         */
+        static size_t hashOf(const Node *n) {
+            return std::hash<KeyType>()(n->key);
+        }
+
+        /**
+         * Whether a's key orders before b's.
+         */
+        static bool keyLess(const Node *a, const Node *b) {
+            return a->key < b->key;
+        }
+
+        /**
+         * Recompute the cached height, count, leaves and path length from
+         * the children's. Must be called whenever left or right changes.
+         */
+        void update() {
+            int lHeight = heightOf(left);
+            int rHeight = heightOf(right);
+            height = (lHeight > rHeight ? lHeight : rHeight) + 1;
+            count = countOf(left) + countOf(right) + 1;
+            leaves = count == 1 ? 1 : leavesOf(left) + leavesOf(right);
+            // everything below me sits one level deeper than below my child
+            pathLength = pathLengthOf(left) + pathLengthOf(right) + count - 1;
         }
 
         /**
@@ -130,330 +518,1180 @@ private:
         *
         * @return  key of the right-most node in this subtree
         */
-        KeyType findMax() const;
+        const KeyType &findMax() const;
 
         /**
          * Checks if this is a leaf node.
          * @return true if leaf
          */
         bool isLeaf() const;
-
-        /**
-         * helper function to count the size of tree
-         * @return number of nodes in a tree
-         */
-        int size(Node *n);
     };
 
     /**
-     * Only data element of IntBST -- the root of the binary search tree.
+     * The root of the binary search tree.
      */
     Node *root;
 
     /**
-    * Recursive helper method for has.
+     * Scratch stack of the links walked by add() and remove(), bottom-most
+     * last, so the path can be rebalanced without recursion. Kept as a
+     * member so its storage is reused from call to call.
+     */
+    std::vector<Node **> path;
+
+    /**
+     * Source of every Node in this tree.
+     */
+    Allocator<Node> alloc;
+
+    /**
+     * Operation counters behind stats(); empty unless BST_STATS is set.
+     * Mutable so that has() can count.
+     */
+    mutable BSTCounters counters;
+
+    /**
+     * Rebalance every subtree on path, from the bottom up, then empty it.
+     * @param op  the operation whose rebalance steps this counts as
+     */
+    void rebalancePath(BSTOp op);
+
+    /**
+    * Iterative helper method for has.
     * @param me   sub-IntBST in which to look for key
     * @param key  key to search for
     * @return     true if found, false otherwise
     */
-    bool has(Node *me, KeyType key) const;
+    bool has(Node *me, const KeyType &key) const;
+
+    /**
+     * Walk down from *link toward key, recording the links passed on path.
+     * @param link  link holding the subtree to search
+     * @param key   key to look for
+     * @return      the empty link where key belongs, or nullptr (with path
+     *              emptied) if key is already an element
+     */
+    Node **findSlot(Node **link, const KeyType &key);
 
     /**
-    * Recursive helper method for add.
+    * Iterative helper method for add.
     * @param me      sub-IntBST to which to add key
-    * @param newKey  key to add
+    * @param newKey  key to add, forwarded into the new Node
     * @return        me, or if me is nullptr, the new Node with newKey
     */
-    Node *add(Node *me, KeyType newKey);
+    template<typename K>
+    Node *add(Node *me, K &&newKey);
 
     /**
-     * Recursive helper method for remove.
+     * Iterative helper method for remove.
      * @param me   sub-IntBST from which to remove key
      * @param key  key to remove
      * @return     me, or my replacement if I get deleted (could be nullptr
      *             if I'm it and also a leaf)
      */
-    Node *remove(Node *me, KeyType key);
+    Node *remove(Node *me, const KeyType &key);
 
     /**
-     * Recursive helper method to delete a subtree.
-     * @param me the root of the subtree to delete
+     * Helper method for assignSorted: builds a minimum-height subtree from
+     * the next n keys of a sorted sequence. Recursion depth is log2(n).
+     * @param next  iterator to the next unused key, advanced past n keys
+     * @param n     number of keys to take
+     * @param pool  allocator for the new nodes
+     * @return      root of the new subtree
      */
-    void clear(Node *me);
+    template<typename ForwardIt>
+    static Node *buildSorted(ForwardIt &next, int n, Allocator<Node> &pool);
 
     /**
-     * Recursive helper method to copy a subtree.
-     * @param me the root of the subtree to copy
-     * @return   a fresh copy of the subtree
+     * Helper method for the threaded assignSorted: builds the left half
+     * on another thread with a pool of its own while this thread builds
+     * the right half, then adopts that pool. Same shape as buildSorted.
      */
-    Node *copy(Node *me);
+    template<typename RandomIt>
+    static Node *buildSorted(RandomIt first, int n, unsigned threads, Allocator<Node> &pool);
 
     /**
-     * Recursive helper method to get the leaf count of a tree
-     * @param node the root of the subtree to start counting
-     * @return total number of leaf in a tree
+     * Relink the whole tree with linkSorted(), after assignSorted() built
+     * it in a shape the policy does not accept.
      */
-    int getLeafCount(Node *node);
+    void relink();
 
     /**
-     * Helper function for getInOrderTraversal()
-     * @param node
-     * @return In order traversal
+     * Delete the whole tree and leave it empty. When the allocator can
+     * release in bulk and nodes need no destructor, this is O(chunks)
+     * rather than O(n).
      */
-    std::string getInOrderTraversal(Node *node);
+    void clearAll();
 
     /**
-     * Helper functions for getPreOrderTraversal()
-     * @param node
-     * @return pre order traversal
+     * Helper method for the join-based operations: a tree of the keys of
+     * l, then m, then r (in that order), as the policy joins them
+     * (Balance::join).
+     * @return  root of the joined tree
      */
-    std::string getPreOrderTraversal(Node *node);
+    static Node *join(Node *l, Node *m, Node *r);
 
     /**
-     * Helper function for getPostOrderTraversal()
-     * @param node
-     * @return post order traversal
+     * join() without a middle node: l's largest node is cut out to be it.
+     */
+    static Node *join(Node *l, Node *r);
+
+    /**
+     * Cut me into the keys below key (l) and above key (r), rejoining the
+     * pieces hanging off the search path.
+     * @return  the node holding key, detached, or nullptr if none
+     */
+    static Node *splitAt(Node *me, const KeyType &key, Node *&l, Node *&r);
+
+    /**
+     * Cut the largest node out of the non-empty tree me.
+     * @param rest  receives the other nodes
+     * @return      the largest node, detached
+     */
+    static Node *splitLast(Node *me, Node *&rest);
+
+    /**
+     * The join-based union, intersection or difference of the trees a
+     * and b. Nodes that do not make it into the result are appended to
+     * garbage rather than freed, since the allocator is not thread-safe;
+     * if garbage is nullptr they are left for the allocator to release.
+     */
+    static Node *combine(SetOp op, Node *a, Node *b, unsigned threads, std::vector<Node *> *garbage);
+
+    /**
+     * The same as combine() in O(|a| + |b|) by merging the two in-order
+     * node lists, for trees too tall for the recursive algorithms (an
+     * Unbalanced tree built from sorted input).
+     */
+    static Node *combineLinear(SetOp op, Node *a, Node *b, std::vector<Node *> *garbage);
+
+    /**
+     * Run op on my tree and other's (whose allocator this tree takes over)
+     * and free the nodes left out.
+     */
+    void setOperation(SetOp op, BST &&other, unsigned threads);
+
+    /**
+     * Whether the recursion of the join-based helpers could get deeper
+     * than a few times log2(size) on me.
+     */
+    static bool tooTall(const Node *me);
+
+    /**
+     * Append the nodes of a subtree to out in in-order, using an explicit
+     * stack.
+     */
+    static void flatten(Node *me, std::vector<Node *> &out);
+
+    /**
+     * Relink nodes[0, n), in key order, into a tree as the policy links
+     * them (Balance::link): of minimum height unless it is a treap.
+     */
+    static Node *linkSorted(Node *const *nodes, size_t n);
+
+    /**
+     * Helper method to delete a subtree in O(1) extra space: the subtree
+     * is rotated right until its root has no left child, then the root is
+     * freed and the walk continues down the right spine.
+     * @param me the root of the subtree to delete
+     */
+    void clear(Node *me);
+
+    /**
+     * Helper method to copy a subtree using an explicit stack.
+     * @param me the root of the subtree to copy
+     * @return   a fresh copy of the subtree
      */
-    std::string getPostOrderTraversal(Node *node);
+    Node *copy(Node *me);
+
     /**
-     * Helper function for the getHeight();
+     * Helper function for the getHeight(); reads the height cached in node.
      * @param node
      * @return height of the tree
      */
-    int getHeight(Node *node);
+    int getHeight(Node *node) const;
 };
 
-template<typename KeyType>
-BST<KeyType>::BST() {
-    root = nullptr;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+BST<KeyType, Balance, Allocator>::BST() : root(nullptr) {
 }
 
-template<typename KeyType>
-BST<KeyType>::~BST() {
-    clear(root);
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+BST<KeyType, Balance, Allocator>::~BST() {
+    clearAll();
 }
 
-template<typename KeyType>
-BST<KeyType>::BST(const BST &other) {
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+BST<KeyType, Balance, Allocator>::BST(const BST &other) : root(nullptr) {
     root = copy(other.root);
 }
 
-template<typename KeyType>
-BST<KeyType> &BST<KeyType>::operator=(const BST &rhs) {
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+BST<KeyType, Balance, Allocator> &BST<KeyType, Balance, Allocator>::operator=(const BST &rhs) {
     if (this != &rhs) {
-        clear(root);
+        clearAll();
         root = copy(rhs.root);
     }
     return *this;
 }
 
-template<typename KeyType>
-bool BST<KeyType>::has(KeyType key) const {
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+BST<KeyType, Balance, Allocator>::BST(BST &&other) noexcept
+        : root(other.root), alloc(std::move(other.alloc)) {
+    other.root = nullptr;
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+BST<KeyType, Balance, Allocator> &BST<KeyType, Balance, Allocator>::operator=(BST &&rhs) noexcept {
+    if (this != &rhs) {
+        clearAll();
+        alloc = std::move(rhs.alloc);
+        root = rhs.root;
+        rhs.root = nullptr;
+    }
+    return *this;
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+bool BST<KeyType, Balance, Allocator>::has(const KeyType &key) const {
     return has(root, key);
 }
 
-template<typename KeyType>
-void BST<KeyType>::add(KeyType newKey) {
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::hasMany(const KeyType *keys, size_t count, bool *results) const {
+    const Node *cursor[LOOKUP_GROUP];
+    size_t slotKey[LOOKUP_GROUP];
+    size_t next = 0, live = 0;
+    for (size_t s = 0; s < LOOKUP_GROUP && next < count; s++, live++) {
+        cursor[s] = root;
+        slotKey[s] = next++;
+    }
+    size_t slots = live;
+
+    while (live > 0) {
+        for (size_t s = 0; s < slots; s++) {
+            if (slotKey[s] == count)
+                continue; // slot retired
+            const Node *me = cursor[s];
+            const KeyType &key = keys[slotKey[s]];
+            bool done = true;
+            if (me != nullptr) {
+                if (key < me->key) {
+                    cursor[s] = me->left;
+                    done = false;
+                } else if (key > me->key) {
+                    cursor[s] = me->right;
+                    done = false;
+                }
+            }
+            if (!done) {
+#if defined(__GNUC__)
+                __builtin_prefetch(cursor[s]);
+#endif
+                continue;
+            }
+            results[slotKey[s]] = me != nullptr;
+            if (next < count) {
+                cursor[s] = root;
+                slotKey[s] = next++;
+            } else {
+                slotKey[s] = count;
+                --live;
+            }
+        }
+    }
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::hasManySorted(const KeyType *keys, size_t count, bool *results) const {
+    struct Range {
+        const Node *node;
+        size_t first, last;
+    };
+    std::vector<Range> todo;
+    todo.reserve(2 * static_cast<size_t>(Node::heightOf(root)) + 1);
+    if (count > 0)
+        todo.push_back(Range{root, 0, count});
+    while (!todo.empty()) {
+        Range r = todo.back();
+        todo.pop_back();
+        if (r.node == nullptr) {
+            std::fill(results + r.first, results + r.last, false);
+            continue;
+        }
+        const KeyType &pivot = r.node->key;
+        size_t lo = std::lower_bound(keys + r.first, keys + r.last, pivot,
+                                     [](const KeyType &a, const KeyType &b) { return a < b; }) - keys;
+        size_t hi = lo;
+        while (hi < r.last && !(pivot < keys[hi]))
+            results[hi++] = true; // equal to pivot (repeats allowed)
+        if (r.first < lo) {
+            todo.push_back(Range{r.node->left, r.first, lo});
+#if defined(__GNUC__)
+            __builtin_prefetch(r.node->left);
+#endif
+        }
+        if (hi < r.last) {
+            todo.push_back(Range{r.node->right, hi, r.last});
+#if defined(__GNUC__)
+            __builtin_prefetch(r.node->right);
+#endif
+        }
+    }
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::add(const KeyType &newKey) {
     root = add(root, newKey);
 }
 
-template<typename KeyType>
-void BST<KeyType>::remove(KeyType key) {
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::add(KeyType &&newKey) {
+    root = add(root, std::move(newKey));
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename... Args>
+void BST<KeyType, Balance, Allocator>::emplace(Args &&... args) {
+    Node *fresh = alloc.create(std::forward<Args>(args)...);
+    counters.allocated(1);
+    Node **link = findSlot(&root, fresh->key);
+    if (link == nullptr) {
+        alloc.destroy(fresh);
+        counters.freed(1);
+        return;
+    }
+    *link = fresh;
+    rebalancePath(BSTOp::Add);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename ForwardIt>
+void BST<KeyType, Balance, Allocator>::assignSorted(ForwardIt first, ForwardIt last) {
+    clearAll();
+    root = buildSorted(first, static_cast<int>(std::distance(first, last)), alloc);
+    if (!Balance::minimumHeightValid)
+        relink();
+    counters.allocated(Node::countOf(root));
+    counters.rebuilt();
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename RandomIt>
+void BST<KeyType, Balance, Allocator>::assignSorted(RandomIt first, RandomIt last, unsigned threads) {
+    clearAll();
+    root = buildSorted(first, static_cast<int>(last - first), threads, alloc);
+    if (!Balance::minimumHeightValid)
+        relink();
+    counters.allocated(Node::countOf(root));
+    counters.rebuilt();
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename InputIt>
+void BST<KeyType, Balance, Allocator>::buildFrom(InputIt first, InputIt last) {
+    std::vector<BuildKey<typename std::iterator_traits<InputIt>::value_type>> keys(first, last);
+    unsigned threads = 1;
+    if (keys.size() >= static_cast<size_t>(PARALLEL_BUILD_CUTOFF)) {
+        threads = std::thread::hardware_concurrency();
+        threads = threads == 0 ? 1 : threads;
+    }
+    buildFromCollected(keys, threads);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename InputIt>
+void BST<KeyType, Balance, Allocator>::buildFrom(InputIt first, InputIt last, unsigned threads) {
+    std::vector<BuildKey<typename std::iterator_traits<InputIt>::value_type>> keys(first, last);
+    buildFromCollected(keys, threads);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename Key>
+void BST<KeyType, Balance, Allocator>::buildFromCollected(std::vector<Key> &keys, unsigned threads) {
+    parallelSort(keys.begin(), keys.end(), threads);
+    keys.erase(std::unique(keys.begin(), keys.end(),
+                           [](const Key &a, const Key &b) { return !(a < b); }),
+               keys.end());
+    assignSorted(std::make_move_iterator(keys.begin()), std::make_move_iterator(keys.end()), threads);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::remove(const KeyType &key) {
     root = remove(root, key);
 }
 
-template<typename KeyType>
-bool BST<KeyType>::isEmpty() {
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+bool BST<KeyType, Balance, Allocator>::isEmpty() const {
     if (root == nullptr)
         return true;
     return false;
 }
 
-template<typename KeyType>
-int BST<KeyType>::size() {
-    return (root->size(root));
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+int BST<KeyType, Balance, Allocator>::size() const {
+    return Node::countOf(root);
 }
 
-template<typename KeyType>
-int BST<KeyType>::getLeafCount() {
-    return getLeafCount(root);
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+int BST<KeyType, Balance, Allocator>::rank(const KeyType &key) const {
+    int smaller = 0;
+    const Node *me = root;
+    while (me != nullptr) {
+        if (key < me->key) {
+            me = me->left;
+        } else if (key > me->key) {
+            smaller += Node::countOf(me->left) + 1;
+            me = me->right;
+        } else {
+            return smaller + Node::countOf(me->left);
+        }
+    }
+    return smaller;
 }
 
-//helper private functions
-template<typename KeyType>
-bool BST<KeyType>::has(BST::Node *me, KeyType key) const {
-    if (me == nullptr)
-        return false; // not found
-    if (key < me->key)
-        return has(me->left, key);
-    else if (key > me->key)
-        return has(me->right, key);
-    else  // key == me->key
-        return true;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+const KeyType &BST<KeyType, Balance, Allocator>::select(int i) const {
+    if (i < 0 || i >= Node::countOf(root))
+        throw std::out_of_range("BST::select: index out of range");
+    const Node *me = root;
+    while (true) {
+        int leftCount = Node::countOf(me->left);
+        if (i < leftCount) {
+            me = me->left;
+        } else if (i > leftCount) {
+            i -= leftCount + 1;
+            me = me->right;
+        } else {
+            return me->key;
+        }
+    }
 }
 
-template<typename KeyType>
-typename BST<KeyType>::Node *BST<KeyType>::add(BST::Node *me, KeyType newKey) {
-    if (me == nullptr)
-        me = new Node(newKey);
-    else if (newKey < me->key)
-        me->left = add(me->left, newKey);
-    else if (newKey > me->key)
-        me->right = add(me->right, newKey);
-    return me;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+const KeyType *BST<KeyType, Balance, Allocator>::lowerBound(const KeyType &key) const {
+    const KeyType *best = nullptr;
+    const Node *me = root;
+    while (me != nullptr) {
+        if (me->key < key) {
+            me = me->right;
+        } else {
+            best = &me->key;
+            me = me->left;
+        }
+    }
+    return best;
 }
 
-template<typename KeyType>
-typename BST<KeyType>::Node *BST<KeyType>::remove(BST::Node *me, KeyType key) {
-    if (me == nullptr)
-        return nullptr;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+const KeyType *BST<KeyType, Balance, Allocator>::upperBound(const KeyType &key) const {
+    const KeyType *best = nullptr;
+    const Node *me = root;
+    while (me != nullptr) {
+        if (key < me->key) {
+            best = &me->key;
+            me = me->left;
+        } else {
+            me = me->right;
+        }
+    }
+    return best;
+}
 
-    if (key < me->key) {
-        me->left = remove(me->left, key);
-        return me;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+int BST<KeyType, Balance, Allocator>::countRange(const KeyType &lo, const KeyType &hi) const {
+    // walk down to the top-most element in range; the two bounds share
+    // the path above it
+    const Node *fork = root;
+    while (fork != nullptr) {
+        if (fork->key < lo)
+            fork = fork->right;
+        else if (!(fork->key < hi))
+            fork = fork->left;
+        else
+            break;
+    }
+    if (fork == nullptr)
+        return 0;
+    int count = 1;
+    for (const Node *me = fork->left; me != nullptr;) {
+        if (me->key < lo) {
+            me = me->right;
+        } else {
+            count += Node::countOf(me->right) + 1;
+            me = me->left;
+        }
+    }
+    for (const Node *me = fork->right; me != nullptr;) {
+        if (me->key < hi) {
+            count += Node::countOf(me->left) + 1;
+            me = me->right;
+        } else {
+            me = me->left;
+        }
+    }
+    return count;
+}
 
-    } else if (key > me->key) {
-        me->right = remove(me->right, key);
-        return me;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename Visit>
+void BST<KeyType, Balance, Allocator>::forEachInRange(const KeyType &lo, const KeyType &hi, Visit visit) const {
+    if (!(lo < hi))
+        return;
+    std::vector<const Node *> todo;
+    todo.reserve(Node::heightOf(root));
+    const Node *me = root;
+    while (me != nullptr || !todo.empty()) {
+        // go down to the smallest key >= lo, skipping subtrees left of lo
+        while (me != nullptr) {
+            if (me->key < lo) {
+                me = me->right;
+            } else {
+                todo.push_back(me);
+                me = me->left;
+            }
+        }
+        if (todo.empty())
+            return; // nothing left is >= lo
+        me = todo.back();
+        todo.pop_back();
+        if (!(me->key < hi))
+            return;
+        visit(me->key);
+        me = me->right;
+    }
+}
 
-    } else {
-        if (me->left == nullptr) {
-            Node *myReplacement = me->right;
-            delete me;
-            return myReplacement;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+int BST<KeyType, Balance, Allocator>::getLeafCount() const {
+    return Node::leavesOf(root);
+}
+
+//helper private functions
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+bool BST<KeyType, Balance, Allocator>::has(BST::Node *me, const KeyType &key) const {
+    BSTTally tally;
+    while (me != nullptr) {
+        tally.visit();
+        if (key < me->key) {
+            tally.compare(1);
+            me = me->left;
+        } else if (key > me->key) {
+            tally.compare(2);
+            me = me->right;
+        } else { // key == me->key
+            tally.compare(2);
+            counters.record(BSTOp::Has, tally);
+            return true;
+        }
+    }
+    counters.record(BSTOp::Has, tally);
+    return false; // not found
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+typename BST<KeyType, Balance, Allocator>::Node **BST<KeyType, Balance, Allocator>::findSlot(BST::Node **link, const KeyType &key) {
+    BSTTally tally;
+    path.clear();
+    while (*link != nullptr) {
+        Node *cur = *link;
+        tally.visit();
+        if (key < cur->key) {
+            tally.compare(1);
+            path.push_back(link);
+            link = &cur->left;
+        } else if (key > cur->key) {
+            tally.compare(2);
+            path.push_back(link);
+            link = &cur->right;
+        } else {
+            tally.compare(2);
+            counters.record(BSTOp::Add, tally);
+            path.clear();
+            return nullptr; // already an element
+        }
+    }
+    counters.record(BSTOp::Add, tally);
+    return link;
+}
 
-        } else if (me->right == nullptr) {
-            Node *myReplacement = me->left;
-            delete me;
-            return myReplacement;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename K>
+typename BST<KeyType, Balance, Allocator>::Node *BST<KeyType, Balance, Allocator>::add(BST::Node *me, K &&newKey) {
+    Node **link = findSlot(&me, newKey);
+    if (link == nullptr)
+        return me; // already an element, shape unchanged
+    *link = alloc.create(std::forward<K>(newKey));
+    counters.allocated(1);
+    rebalancePath(BSTOp::Add);
+    return me;
+}
 
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+typename BST<KeyType, Balance, Allocator>::Node *BST<KeyType, Balance, Allocator>::remove(BST::Node *me, const KeyType &key) {
+    BSTTally tally;
+    Node **link = &me;
+    while (*link != nullptr) {
+        Node *cur = *link;
+        tally.visit();
+        if (key < cur->key) {
+            tally.compare(1);
+            path.push_back(link);
+            link = &cur->left;
+        } else if (key > cur->key) {
+            tally.compare(2);
+            path.push_back(link);
+            link = &cur->right;
         } else {
-            me->key = me->left->findMax();
-            me->left = remove(me->left, me->key);
-            return me;
+            tally.compare(2);
+            break;
+        }
+    }
+    counters.record(BSTOp::Remove, tally);
+    if (*link == nullptr) {
+        path.clear();
+        return me; // not an element
+    }
+
+    Node *target = *link;
+    if (target->left == nullptr) {
+        *link = target->right;
+        alloc.destroy(target);
+        counters.freed(1);
+
+    } else if (target->right == nullptr) {
+        *link = target->left;
+        alloc.destroy(target);
+        counters.freed(1);
+
+    } else {
+        // replace my key with my predecessor's and unlink the predecessor
+        path.push_back(link);
+        Node **maxLink = &target->left;
+        while ((*maxLink)->right != nullptr) {
+            path.push_back(maxLink);
+            maxLink = &(*maxLink)->right;
         }
+        Node *maxNode = *maxLink;
+        target->key = std::move(maxNode->key);
+        *maxLink = maxNode->left;
+        alloc.destroy(maxNode);
+        counters.freed(1);
     }
+    rebalancePath(BSTOp::Remove);
+    return me;
 }
 
-template<typename KeyType>
-void BST<KeyType>::clear(BST::Node *me) {
-    if (me != nullptr) {
-        clear(me->left);
-        clear(me->right);
-        delete me;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::rebalancePath(BSTOp op) {
+    for (size_t i = path.size(); i-- > 0;) {
+        Node *before = *path[i];
+        *path[i] = Balance::rebalance(before);
+        counters.rebalanced(op, *path[i] != before);
     }
+    path.clear();
 }
 
-template<typename KeyType>
-typename BST<KeyType>::Node *BST<KeyType>::copy(BST::Node *me) {
-    if (me == nullptr)
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename ForwardIt>
+typename BST<KeyType, Balance, Allocator>::Node *
+BST<KeyType, Balance, Allocator>::buildSorted(ForwardIt &next, int n, Allocator<Node> &pool) {
+    if (n == 0)
         return nullptr;
-    else
-        return new Node(me->key, copy(me->left), copy(me->right));
+    int leftCount = n / 2;
+    Node *left = buildSorted(next, leftCount, pool);
+    Node *me = pool.create(*next);
+    ++next;
+    me->left = left;
+    me->right = buildSorted(next, n - leftCount - 1, pool);
+    me->update();
+    return me;
 }
 
-template<typename KeyType>
-int BST<KeyType>::getLeafCount(BST::Node *node) {
-    if (node == nullptr) {
-        return 0;
-    } else if (node->isLeaf()) {
-        return 1;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename RandomIt>
+typename BST<KeyType, Balance, Allocator>::Node *
+BST<KeyType, Balance, Allocator>::buildSorted(RandomIt first, int n, unsigned threads, Allocator<Node> &pool) {
+    if (threads <= 1 || n < PARALLEL_BUILD_CUTOFF) {
+        RandomIt next = first;
+        return buildSorted(next, n, pool);
     }
-    return getLeafCount(node->left) + getLeafCount(node->right);
+    int leftCount = n / 2;
+    unsigned leftThreads = threads / 2;
+    Allocator<Node> leftPool;
+    auto left = std::async(std::launch::async, [first, leftCount, leftThreads, &leftPool] {
+        return buildSorted(first, leftCount, leftThreads, leftPool);
+    });
+    Node *me = pool.create(first[leftCount]);
+    me->right = buildSorted(first + leftCount + 1, n - leftCount - 1, threads - leftThreads, pool);
+    me->left = left.get();
+    pool.adopt(std::move(leftPool));
+    me->update();
+    return me;
 }
 
-template<typename KeyType>
-KeyType BST<KeyType>::Node::findMax() const {
-    if (right == nullptr)
-        return this->key;
-    else
-        return right->findMax();
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::relink() {
+    std::vector<Node *> nodes;
+    nodes.reserve(size());
+    flatten(root, nodes);
+    root = linkSorted(nodes.data(), nodes.size());
 }
 
-template<typename KeyType>
-bool BST<KeyType>::Node::isLeaf() const {
-    if (right == nullptr && left == nullptr)
-        return true;
-    return false;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::clearAll() {
+    if (Allocator<Node>::bulkRelease && std::is_trivially_destructible<Node>::value) {
+        counters.freed(Node::countOf(root));
+        alloc.releaseAll();
+    } else {
+        clear(root);
+    }
+    root = nullptr;
 }
 
-template<typename KeyType>
-int BST<KeyType>::Node::size(BST::Node *n) {
-    if (n == nullptr)
-        return 0;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::clear(BST::Node *me) {
+    while (me != nullptr) {
+        if (me->left != nullptr) {
+            Node *pivot = me->left;
+            me->left = pivot->right;
+            pivot->right = me;
+            me = pivot;
+        } else {
+            Node *next = me->right;
+            alloc.destroy(me);
+            counters.freed(1);
+            me = next;
+        }
+    }
+}
 
-    return size(n->right) + 1 + size(n->left);
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+typename BST<KeyType, Balance, Allocator>::Node *BST<KeyType, Balance, Allocator>::copy(BST::Node *me) {
+    Node *result = nullptr;
+    std::vector<std::pair<const Node *, Node **>> todo;
+    if (me != nullptr)
+        todo.emplace_back(me, &result);
+    while (!todo.empty()) {
+        const Node *src = todo.back().first;
+        Node **dst = todo.back().second;
+        todo.pop_back();
+
+        Node *n = alloc.create(src->key);
+        counters.allocated(1);
+        n->height = src->height;
+        n->count = src->count;
+        n->leaves = src->leaves;
+        n->pathLength = src->pathLength;
+        *dst = n;
+        if (src->right != nullptr)
+            todo.emplace_back(src->right, &n->right);
+        if (src->left != nullptr)
+            todo.emplace_back(src->left, &n->left);
+    }
+    return result;
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+const KeyType &BST<KeyType, Balance, Allocator>::Node::findMax() const {
+    const Node *n = this;
+    while (n->right != nullptr)
+        n = n->right;
+    return n->key;
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+bool BST<KeyType, Balance, Allocator>::Node::isLeaf() const {
+    if (right == nullptr && left == nullptr)
+        return true;
+    return false;
 }
 
-template<typename KeyType>
-int BST<KeyType>::getHeight() {
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+int BST<KeyType, Balance, Allocator>::getHeight() const {
     return getHeight(root);
 }
 
-template<typename KeyType>
-std::string BST<KeyType>::getInOrderTraversal() {
-    return getInOrderTraversal(root);
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+long long BST<KeyType, Balance, Allocator>::getPathLength() const {
+    return Node::pathLengthOf(root);
 }
 
-template<typename KeyType>
-std::string BST<KeyType>::getPreOrderTraversal() {
-    return getPreOrderTraversal(root);
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+double BST<KeyType, Balance, Allocator>::getAverageDepth() const {
+    if (root == nullptr)
+        return 0;
+    return 1 + static_cast<double>(root->pathLength) / root->count;
 }
 
-template<typename KeyType>
-std::string BST<KeyType>::getPostOrderTraversal() {
-    return getPostOrderTraversal(root);
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+BSTStats BST<KeyType, Balance, Allocator>::stats() const {
+    BSTStats out;
+    counters.snapshot(out);
+    out.size = size();
+    out.height = getHeight();
+    out.leaves = getLeafCount();
+    out.averageDepth = getAverageDepth();
+    return out;
 }
 
-template<typename KeyType>
-std::string BST<KeyType>::getInOrderTraversal(BST::Node *node) {
-    if (node == nullptr)
-        return "";
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::resetStats() {
+    counters.reset();
+}
 
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+std::string BST<KeyType, Balance, Allocator>::getInOrderTraversal() const {
     std::ostringstream ss;
-    ss << getInOrderTraversal(node->left);
-    ss << node->key << " ";
-    ss <<getInOrderTraversal(node->right);
+    forEachInOrder([&ss](const KeyType &key) { ss << key << " "; });
     return ss.str();
 }
 
-template<typename KeyType>
-std::string BST<KeyType>::getPreOrderTraversal(BST::Node *node) {
-    if (node == nullptr)
-        return "";
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+std::string BST<KeyType, Balance, Allocator>::getPreOrderTraversal() const {
     std::ostringstream ss;
-    ss << node->key << " ";
-    ss << getPreOrderTraversal(node->left);
-    ss << getPreOrderTraversal(node->right);
+    forEachPreOrder([&ss](const KeyType &key) { ss << key << " "; });
     return ss.str();
 }
 
-template<typename KeyType>
-std::string BST<KeyType>::getPostOrderTraversal(BST::Node *node) {
-    if (node == nullptr)
-        return "";
-
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+std::string BST<KeyType, Balance, Allocator>::getPostOrderTraversal() const {
     std::ostringstream ss;
-    ss << getPostOrderTraversal(node->left);
-    ss << getPostOrderTraversal(node->right);
-    ss << node->key << " ";
+    forEachPostOrder([&ss](const KeyType &key) { ss << key << " "; });
     return ss.str();
 }
 
-template<typename KeyType>
-int BST<KeyType>::getHeight(BST::Node *node) {
-    if (node == nullptr)
-        return 0;
-    else{
-        int lHeight = getHeight(node->left) + 1;
-        int rHeight = getHeight(node->right) + 1;
-
-        if (lHeight > rHeight){
-            return lHeight;
-        }else{
-            return rHeight;
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename Visit>
+void BST<KeyType, Balance, Allocator>::forEachInOrder(Visit visit) const {
+    std::vector<const Node *> todo;
+    todo.reserve(Node::heightOf(root));
+    const Node *me = root;
+    while (me != nullptr || !todo.empty()) {
+        while (me != nullptr) {
+            todo.push_back(me);
+            me = me->left;
         }
+        me = todo.back();
+        todo.pop_back();
+        visit(me->key);
+        me = me->right;
+    }
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename Visit>
+void BST<KeyType, Balance, Allocator>::forEachPreOrder(Visit visit) const {
+    std::vector<const Node *> todo;
+    todo.reserve(Node::heightOf(root));
+    if (root != nullptr)
+        todo.push_back(root);
+    while (!todo.empty()) {
+        const Node *me = todo.back();
+        todo.pop_back();
+        visit(me->key);
+        if (me->right != nullptr)
+            todo.push_back(me->right);
+        if (me->left != nullptr)
+            todo.push_back(me->left);
     }
 }
 
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+template<typename Visit>
+void BST<KeyType, Balance, Allocator>::forEachPostOrder(Visit visit) const {
+    std::vector<const Node *> todo;
+    todo.reserve(Node::heightOf(root));
+    const Node *me = root, *lastVisited = nullptr;
+    while (me != nullptr || !todo.empty()) {
+        if (me != nullptr) {
+            todo.push_back(me);
+            me = me->left;
+        } else {
+            const Node *top = todo.back();
+            if (top->right != nullptr && top->right != lastVisited) {
+                me = top->right;
+            } else {
+                visit(top->key);
+                lastVisited = top;
+                todo.pop_back();
+            }
+        }
+    }
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+int BST<KeyType, Balance, Allocator>::getHeight(BST::Node *node) const {
+    return Node::heightOf(node);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+BST<KeyType, Balance, Allocator> BST<KeyType, Balance, Allocator>::split(const KeyType &key) {
+    Node *left, *right;
+    if (tooTall(root)) {
+        std::vector<Node *> nodes;
+        flatten(root, nodes);
+        size_t cut = std::partition_point(nodes.begin(), nodes.end(),
+                                          [&key](const Node *n) { return n->key < key; }) - nodes.begin();
+        left = linkSorted(nodes.data(), cut);
+        right = linkSorted(nodes.data() + cut, nodes.size() - cut);
+        counters.rebuilt();
+    } else {
+        Node *match = splitAt(root, key, left, right);
+        if (match != nullptr)
+            right = join(nullptr, match, right);
+    }
+    root = left;
+
+    BST rest;
+    if (Allocator<Node>::bulkRelease) {
+        rest.root = rest.copy(right);
+        clear(right);
+    } else {
+        rest.root = right;
+    }
+    return rest;
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::join(BST &&right) {
+    if (root != nullptr && right.root != nullptr) {
+        const Node *first = right.root;
+        while (first->left != nullptr)
+            first = first->left;
+        if (!(root->findMax() < first->key))
+            throw std::invalid_argument("BST::join: right holds keys not above this set's");
+    }
+    alloc.adopt(std::move(right.alloc));
+    Node *r = right.root;
+    right.root = nullptr;
+    if (tooTall(root) || tooTall(r)) {
+        std::vector<Node *> nodes;
+        flatten(root, nodes);
+        flatten(r, nodes);
+        root = linkSorted(nodes.data(), nodes.size());
+        counters.rebuilt();
+    } else {
+        root = join(root, r);
+    }
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::unionWith(BST other) {
+    unsigned threads = std::thread::hardware_concurrency();
+    setOperation(SetOp::Union, std::move(other), threads == 0 ? 1 : threads);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::unionWith(BST other, unsigned threads) {
+    setOperation(SetOp::Union, std::move(other), threads);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::intersectWith(BST other) {
+    unsigned threads = std::thread::hardware_concurrency();
+    setOperation(SetOp::Intersection, std::move(other), threads == 0 ? 1 : threads);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::intersectWith(BST other, unsigned threads) {
+    setOperation(SetOp::Intersection, std::move(other), threads);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::differenceWith(BST other) {
+    unsigned threads = std::thread::hardware_concurrency();
+    setOperation(SetOp::Difference, std::move(other), threads == 0 ? 1 : threads);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::differenceWith(BST other, unsigned threads) {
+    setOperation(SetOp::Difference, std::move(other), threads);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::setOperation(SetOp op, BST &&other, unsigned threads) {
+    alloc.adopt(std::move(other.alloc));
+    Node *b = other.root;
+    other.root = nullptr;
+    bool linear = tooTall(root) || tooTall(b);
+    if (linear)
+        counters.rebuilt();
+    if (op == SetOp::Intersection && Allocator<Node>::bulkRelease && std::is_trivially_destructible<Node>::value) {
+        // an intersection can leave out nearly all of a big tree; rather
+        // than visit each node left out, copy the result (no bigger than
+        // the smaller input) into a fresh allocator and drop the old one
+        int inputs = Node::countOf(root) + Node::countOf(b);
+        Node *result = linear ? combineLinear(op, root, b, nullptr) : combine(op, root, b, threads, nullptr);
+        Allocator<Node> old(std::move(alloc));
+        root = copy(result);
+        counters.freed(inputs);
+        old.releaseAll();
+        return;
+    }
+    std::vector<Node *> garbage;
+    root = linear ? combineLinear(op, root, b, &garbage) : combine(op, root, b, threads, &garbage);
+    for (Node *n : garbage)
+        alloc.destroy(n);
+    counters.freed(garbage.size());
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+typename BST<KeyType, Balance, Allocator>::Node *
+BST<KeyType, Balance, Allocator>::join(Node *l, Node *m, Node *r) {
+    return Balance::join(l, m, r);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+typename BST<KeyType, Balance, Allocator>::Node *
+BST<KeyType, Balance, Allocator>::join(Node *l, Node *r) {
+    if (l == nullptr)
+        return r;
+    Node *rest;
+    Node *last = splitLast(l, rest);
+    return join(rest, last, r);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+typename BST<KeyType, Balance, Allocator>::Node *
+BST<KeyType, Balance, Allocator>::splitAt(Node *me, const KeyType &key, Node *&l, Node *&r) {
+    if (me == nullptr) {
+        l = r = nullptr;
+        return nullptr;
+    }
+    Node *match;
+    if (key < me->key) {
+        Node *inner;
+        match = splitAt(me->left, key, l, inner);
+        r = join(inner, me, me->right);
+    } else if (me->key < key) {
+        Node *inner;
+        match = splitAt(me->right, key, inner, r);
+        l = join(me->left, me, inner);
+    } else {
+        l = me->left;
+        r = me->right;
+        me->left = me->right = nullptr;
+        me->update();
+        match = me;
+    }
+    return match;
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+typename BST<KeyType, Balance, Allocator>::Node *
+BST<KeyType, Balance, Allocator>::splitLast(Node *me, Node *&rest) {
+    if (me->right == nullptr) {
+        rest = me->left;
+        me->left = nullptr;
+        me->update();
+        return me;
+    }
+    Node *inner;
+    Node *last = splitLast(me->right, inner);
+    rest = join(me->left, me, inner);
+    return last;
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+typename BST<KeyType, Balance, Allocator>::Node *
+BST<KeyType, Balance, Allocator>::combine(SetOp op, Node *a, Node *b, unsigned threads,
+                                          std::vector<Node *> *garbage) {
+    if (a == nullptr || b == nullptr) {
+        if (op == SetOp::Union)
+            return a == nullptr ? b : a;
+        if (garbage != nullptr)
+            flatten(b, *garbage); // nothing of b is kept either way
+        if (op == SetOp::Intersection) {
+            if (garbage != nullptr)
+                flatten(a, *garbage);
+            return nullptr;
+        }
+        return a;
+    }
+
+    Node *bLeft, *bRight;
+    Node *match = splitAt(b, a->key, bLeft, bRight);
+    Node *aLeft = a->left, *aRight = a->right;
+    Node *l, *r;
+    if (threads > 1 && Node::countOf(a) + Node::countOf(b) >= PARALLEL_SET_CUTOFF) {
+        unsigned leftThreads = threads / 2;
+        std::vector<Node *> leftGarbage;
+        std::vector<Node *> *leftTarget = garbage == nullptr ? nullptr : &leftGarbage;
+        auto left = std::async(std::launch::async, [op, aLeft, bLeft, leftThreads, leftTarget] {
+            return combine(op, aLeft, bLeft, leftThreads, leftTarget);
+        });
+        r = combine(op, aRight, bRight, threads - leftThreads, garbage);
+        l = left.get();
+        if (garbage != nullptr)
+            garbage->insert(garbage->end(), leftGarbage.begin(), leftGarbage.end());
+    } else {
+        l = combine(op, aLeft, bLeft, 1, garbage);
+        r = combine(op, aRight, bRight, 1, garbage);
+    }
+
+    bool keep = op == SetOp::Union || (op == SetOp::Intersection) == (match != nullptr);
+    if (match != nullptr && garbage != nullptr)
+        garbage->push_back(match);
+    if (keep)
+        return join(l, a, r);
+    if (garbage != nullptr)
+        garbage->push_back(a);
+    return join(l, r);
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+typename BST<KeyType, Balance, Allocator>::Node *
+BST<KeyType, Balance, Allocator>::combineLinear(SetOp op, Node *a, Node *b, std::vector<Node *> *garbage) {
+    std::vector<Node *> as, bs, kept, dropped;
+    flatten(a, as);
+    flatten(b, bs);
+    kept.reserve(op == SetOp::Union ? as.size() + bs.size() : as.size());
+    size_t i = 0, j = 0;
+    while (i < as.size() || j < bs.size()) {
+        if (j == bs.size() || (i < as.size() && as[i]->key < bs[j]->key)) {
+            // only in a
+            (op == SetOp::Intersection ? dropped : kept).push_back(as[i++]);
+        } else if (i == as.size() || bs[j]->key < as[i]->key) {
+            // only in b
+            (op == SetOp::Union ? kept : dropped).push_back(bs[j++]);
+        } else {
+            (op == SetOp::Difference ? dropped : kept).push_back(as[i++]);
+            dropped.push_back(bs[j++]);
+        }
+    }
+    if (garbage != nullptr)
+        garbage->insert(garbage->end(), dropped.begin(), dropped.end());
+    return linkSorted(kept.data(), kept.size());
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+bool BST<KeyType, Balance, Allocator>::tooTall(const Node *me) {
+    int log2 = 0;
+    while ((1L << log2) <= Node::countOf(me))
+        ++log2;
+    return Node::heightOf(me) > 2 * log2 + 8;
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void BST<KeyType, Balance, Allocator>::flatten(Node *me, std::vector<Node *> &out) {
+    std::vector<Node *> todo;
+    while (me != nullptr || !todo.empty()) {
+        while (me != nullptr) {
+            todo.push_back(me);
+            me = me->left;
+        }
+        me = todo.back();
+        todo.pop_back();
+        out.push_back(me);
+        me = me->right;
+    }
+}
+
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+typename BST<KeyType, Balance, Allocator>::Node *
+BST<KeyType, Balance, Allocator>::linkSorted(Node *const *nodes, size_t n) {
+    return Balance::link(nodes, n);
+}
+
 #endif //PROJECT3_BST_H
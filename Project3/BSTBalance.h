@@ -0,0 +1,300 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_BSTBALANCE_H
+#define PROJECT3_BSTBALANCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @file BSTBalance.h - balancing policies for BST<KeyType, Balance>
+ *
+ * A balancing policy is a class with static hooks,
+ *
+ *     template<typename Node> static Node *rebalance(Node *me);
+ *
+ * which BST calls on every node of the path touched by add() or remove(),
+ * from the bottom up, after that node's children have been fixed. The hook
+ * must leave me's cached fields up to date (Node::update) and return the
+ * node that now roots me's subtree.
+ *
+ *     template<typename Node> static Node *join(Node *l, Node *m, Node *r);
+ *     template<typename Node> static Node *link(Node *const *nodes, size_t n);
+ *
+ * build a valid tree of the keys of l, then m, then r, and of the n
+ * detached nodes given in key order; split, join and the set operations
+ * are made of these. Finally minimumHeightValid says whether a tree of
+ * minimum height, as assignSorted() builds it, always satisfies the
+ * policy; if not, assignSorted() relinks it with link().
+ *
+ * Policies see nodes only through left, right, update() and the static
+ * Node helpers: heightOf(n) for the height-shaped ones, hashOf(n) (a
+ * std::hash of n's key) and keyLess(a, b) for TreapBalance. BST and
+ * StringBST nodes provide all of them.
+ */
+
+/**
+ * Single rotations shared by the balancing policies.
+ */
+struct TreeRotations {
+    /**
+     * Rotate me's left child up into me's place.
+     * @param me  subtree root with a non-null left child
+     * @return    the new subtree root
+     */
+    template<typename Node>
+    static Node *rotateRight(Node *me) {
+        Node *pivot = me->left;
+        me->left = pivot->right;
+        pivot->right = me;
+        me->update();
+        pivot->update();
+        return pivot;
+    }
+
+    /**
+     * Rotate me's right child up into me's place.
+     * @param me  subtree root with a non-null right child
+     * @return    the new subtree root
+     */
+    template<typename Node>
+    static Node *rotateLeft(Node *me) {
+        Node *pivot = me->right;
+        me->right = pivot->left;
+        pivot->left = me;
+        me->update();
+        pivot->update();
+        return pivot;
+    }
+};
+
+/**
+ * join and link for the policies whose invariant is about subtree
+ * heights and holds for any tree of minimum height.
+ * @tparam Policy  the policy deriving from this, whose rebalance() join uses
+ */
+template<typename Policy>
+struct HeightShaped : TreeRotations {
+    static constexpr bool minimumHeightValid = true;
+
+    /**
+     * Descend the spine of the taller of l and r until the heights are
+     * within one, put m there, and rebalance on the way back up.
+     * Recursion depth is the height difference of l and r.
+     */
+    template<typename Node>
+    static Node *join(Node *l, Node *m, Node *r) {
+        int lHeight = Node::heightOf(l), rHeight = Node::heightOf(r);
+        if (lHeight > rHeight + 1) {
+            l->right = join(l->right, m, r);
+            return Policy::rebalance(l);
+        }
+        if (rHeight > lHeight + 1) {
+            r->left = join(l, m, r->left);
+            return Policy::rebalance(r);
+        }
+        m->left = l;
+        m->right = r;
+        return Policy::rebalance(m);
+    }
+
+    /**
+     * The middle node over the two halves: a tree of minimum height.
+     */
+    template<typename Node>
+    static Node *link(Node *const *nodes, size_t n) {
+        if (n == 0)
+            return nullptr;
+        size_t leftCount = n / 2;
+        Node *me = nodes[leftCount];
+        me->left = link(nodes, leftCount);
+        me->right = link(nodes + leftCount + 1, n - leftCount - 1);
+        me->update();
+        return me;
+    }
+};
+
+/**
+ * Default policy: the tree keeps whatever shape the insert/remove order
+ * gives it (the classic textbook BST).
+ */
+struct Unbalanced : HeightShaped<Unbalanced> {
+    template<typename Node>
+    static Node *rebalance(Node *me) {
+        me->update();
+        return me;
+    }
+};
+
+/**
+ * AVL policy: the heights of any node's two subtrees differ by at most one,
+ * so the height of the tree stays below 1.45 log2(n + 2) whatever the
+ * insert order.
+ */
+struct AVLBalance : HeightShaped<AVLBalance> {
+    template<typename Node>
+    static Node *rebalance(Node *me) {
+        me->update();
+        int balance = Node::heightOf(me->left) - Node::heightOf(me->right);
+        if (balance > 1) {
+            if (Node::heightOf(me->left->left) < Node::heightOf(me->left->right))
+                me->left = rotateLeft(me->left);
+            return rotateRight(me);
+        } else if (balance < -1) {
+            if (Node::heightOf(me->right->right) < Node::heightOf(me->right->left))
+                me->right = rotateRight(me->right);
+            return rotateLeft(me);
+        }
+        return me;
+    }
+};
+
+/**
+ * Treap policy: every key gets a priority, a hash of the key, and each
+ * node outranks its children, so the tree is the one inserting the keys
+ * by falling priority would give: expected height O(log n) whatever the
+ * insert order, and (priorities being a function of the keys) the same
+ * shape for the same keys every time, whatever the order of the updates
+ * that produced them. Updates cost a hash per node looked at and a few
+ * rotations on average, with no heights compared, and join and link
+ * follow the priorities directly.
+ *
+ * Priorities come from Node::hashOf, std::hash of the key (for
+ * StringBST, of its bytes, so it builds the same tree as BST<std::string>),
+ * mixed further since std::hash of an integer is the integer; equal
+ * priorities rank the smaller key first.
+ */
+struct TreapBalance {
+    static constexpr bool minimumHeightValid = false;
+
+    /**
+     * me's subtrees are treaps: rotate up whichever child outranks me, if
+     * either does, and repeat below until me is in its place (after an
+     * insert that is one rotation; after remove() gives me a new key, it
+     * sinks me).
+     */
+    template<typename Node>
+    static Node *rebalance(Node *me) {
+        Node *up = me;
+        uint64_t top = priority(me);
+        if (me->left != nullptr) {
+            uint64_t p = priority(me->left);
+            if (outranks(p, me->left, top, up)) {
+                up = me->left;
+                top = p;
+            }
+        }
+        if (me->right != nullptr && outranks(priority(me->right), me->right, top, up))
+            up = me->right;
+        if (up == me) {
+            me->update();
+            return me;
+        }
+        return rotateUp(me, up);
+    }
+
+    /**
+     * rebalance() once a child outranks me: rotate that child up and
+     * rebalance me below it. Kept apart so that the common case, no
+     * rotation, inlines into the caller's loop.
+     */
+    template<typename Node>
+    static Node *rotateUp(Node *me, Node *up) {
+        if (up == me->left) {
+            me->left = up->right;
+            up->right = rebalance(me);
+        } else {
+            me->right = up->left;
+            up->left = rebalance(me);
+        }
+        up->update();
+        return up;
+    }
+
+    /**
+     * The highest ranked of the three roots stays on top, and the other
+     * two are joined below it. Expected recursion depth O(log n).
+     */
+    template<typename Node>
+    static Node *join(Node *l, Node *m, Node *r) {
+        if (l != nullptr && outranks(l, m) && (r == nullptr || outranks(l, r))) {
+            l->right = join(l->right, m, r);
+            l->update();
+            return l;
+        }
+        if (r != nullptr && outranks(r, m)) {
+            r->left = join(l, m, r->left);
+            r->update();
+            return r;
+        }
+        m->left = l;
+        m->right = r;
+        m->update();
+        return m;
+    }
+
+    /**
+     * The treap of the nodes in O(n): each node in turn takes over the
+     * part of the right spine it outranks as its left subtree.
+     */
+    template<typename Node>
+    static Node *link(Node *const *nodes, size_t n) {
+        std::vector<Node *> spine;
+        for (size_t i = 0; i < n; i++) {
+            Node *me = nodes[i], *below = nullptr;
+            while (!spine.empty() && outranks(me, spine.back())) {
+                below = spine.back();
+                spine.pop_back();
+                below->update(); // complete: everything after me goes elsewhere
+            }
+            me->left = below;
+            me->right = nullptr;
+            if (!spine.empty())
+                spine.back()->right = me;
+            spine.push_back(me);
+        }
+        for (size_t i = spine.size(); i-- > 0;)
+            spine[i]->update();
+        return spine.empty() ? nullptr : spine.front();
+    }
+
+    /**
+     * The priority of a key with std::hash h: h mixed by the splitmix64
+     * finalizer.
+     */
+    static uint64_t priorityOfHash(uint64_t h) {
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    }
+
+    /**
+     * The priority of n's key.
+     */
+    template<typename Node>
+    static uint64_t priority(const Node *n) {
+        return priorityOfHash(Node::hashOf(n));
+    }
+
+    /**
+     * Whether a, of priority pa, belongs above b, of priority pb.
+     */
+    template<typename Node>
+    static bool outranks(uint64_t pa, const Node *a, uint64_t pb, const Node *b) {
+        return pa > pb || (pa == pb && Node::keyLess(a, b));
+    }
+
+    /**
+     * Whether a belongs above b.
+     */
+    template<typename Node>
+    static bool outranks(const Node *a, const Node *b) {
+        return outranks(priority(a), a, priority(b), b);
+    }
+};
+
+#endif //PROJECT3_BSTBALANCE_H
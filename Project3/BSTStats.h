@@ -0,0 +1,230 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_BSTSTATS_H
+#define PROJECT3_BSTSTATS_H
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#if BST_STATS
+#include <atomic>
+#endif
+
+/**
+ * @file BSTStats.h - opt-in operation counters for BST
+ *
+ * Compiled out unless BST_STATS is defined to 1 (cmake -DBST_STATS=ON):
+ * the counting calls below are then empty inline functions and BST
+ * generates the same code as without them. With it, every tree counts,
+ * per operation type, the calls, key comparisons, nodes visited and
+ * rebalancing steps, plus node allocations, frees, bulk rebuilds and
+ * a histogram of has() depths, readable as a BSTStats snapshot.
+ *
+ * Each call tallies into a local BSTTally and adds it to the tree's
+ * counters once at the end, with relaxed atomics, so readers calling
+ * has() on a shared tree from several threads count correctly.
+ */
+
+#ifndef BST_STATS
+#define BST_STATS 0
+#endif
+
+/**
+ * Operation types counted separately
+ */
+enum class BSTOp {
+    Has, Add, Remove
+};
+
+/**
+ * Counts for one operation type
+ */
+struct BSTOpStats {
+    uint64_t calls = 0;
+    uint64_t comparisons = 0;    // key comparisons (< and > counted apart)
+    uint64_t nodesVisited = 0;
+    uint64_t rebalances = 0;     // rebalance steps that changed a subtree root;
+                                 // a double rotation counts once
+};
+
+/**
+ * Snapshot of a tree's counters and shape, from BST::stats()
+ */
+struct BSTStats {
+    /**
+     * Buckets of lookupDepth; the last one also holds every deeper lookup.
+     */
+    static const int DEPTH_BUCKETS = 64;
+
+    bool enabled = BST_STATS != 0;  // false: everything below except the
+                                    // shape is 0
+    int size = 0;
+    int height = 0;
+    int leaves = 0;
+    double averageDepth = 0;        // what a has() hit costs, spread evenly
+    BSTOpStats has, add, remove;
+    uint64_t allocations = 0;
+    uint64_t frees = 0;
+    uint64_t rebuilds = 0;          // whole trees built or relinked at once
+    uint64_t lookupDepth[DEPTH_BUCKETS] = {};  // has() calls by nodes visited
+
+    /**
+     * Mean nodes visited per has(), or 0 before any.
+     */
+    double meanLookupDepth() const {
+        return has.calls == 0 ? 0 : static_cast<double>(has.nodesVisited) / has.calls;
+    }
+
+    /**
+     * The snapshot as one JSON object; lookup_depth[d] counts the has()
+     * calls that visited d nodes, trailing zero buckets left out.
+     */
+    std::string toJson() const {
+        std::ostringstream out;
+        auto op = [&out](const char *name, const BSTOpStats &s) {
+            out << "\"" << name << "\": {\"calls\": " << s.calls << ", \"comparisons\": " << s.comparisons
+                << ", \"nodes_visited\": " << s.nodesVisited << ", \"rebalances\": " << s.rebalances << "}";
+        };
+        out << "{\"enabled\": " << (enabled ? "true" : "false") << ", \"size\": " << size
+            << ", \"height\": " << height << ", \"leaves\": " << leaves << ", \"average_depth\": "
+            << averageDepth << ", \"allocations\": " << allocations << ", \"frees\": " << frees
+            << ", \"rebuilds\": " << rebuilds << ", \"mean_lookup_depth\": " << meanLookupDepth() << ", ";
+        op("has", has);
+        out << ", ";
+        op("add", add);
+        out << ", ";
+        op("remove", remove);
+        int used = DEPTH_BUCKETS;
+        while (used > 0 && lookupDepth[used - 1] == 0)
+            --used;
+        out << ", \"lookup_depth\": [";
+        for (int d = 0; d < used; d++)
+            out << (d == 0 ? "" : ", ") << lookupDepth[d];
+        out << "]}";
+        return out.str();
+    }
+};
+
+/**
+ * What one call did, counted in registers until it is recorded
+ */
+struct BSTTally {
+#if BST_STATS
+    uint64_t comparisons = 0, nodesVisited = 0;
+
+    void visit() {
+        ++nodesVisited;
+    }
+
+    void compare(int n) {
+        comparisons += static_cast<uint64_t>(n);
+    }
+#else
+    void visit() {}
+
+    void compare(int) {}
+#endif
+};
+
+/**
+ * The running counters of one tree
+ */
+class BSTCounters {
+public:
+#if BST_STATS
+    BSTCounters() = default;
+
+    /**
+     * A copied or moved-to tree starts counting from zero.
+     */
+    BSTCounters(const BSTCounters &) {}
+
+    BSTCounters &operator=(const BSTCounters &) {
+        return *this;
+    }
+
+    void record(BSTOp op, const BSTTally &tally) {
+        Op &o = ops[static_cast<int>(op)];
+        o.calls.fetch_add(1, std::memory_order_relaxed);
+        o.comparisons.fetch_add(tally.comparisons, std::memory_order_relaxed);
+        o.nodesVisited.fetch_add(tally.nodesVisited, std::memory_order_relaxed);
+        if (op == BSTOp::Has) {
+            uint64_t d = tally.nodesVisited < BSTStats::DEPTH_BUCKETS ? tally.nodesVisited : BSTStats::DEPTH_BUCKETS - 1;
+            depth[d].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void rebalanced(BSTOp op, bool changed) {
+        if (changed)
+            ops[static_cast<int>(op)].rebalances.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void allocated(uint64_t n) {
+        allocations.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void freed(uint64_t n) {
+        frees.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void rebuilt() {
+        rebuilds.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void snapshot(BSTStats &out) const {
+        BSTOpStats *targets[] = {&out.has, &out.add, &out.remove};
+        for (int i = 0; i < 3; i++) {
+            targets[i]->calls = ops[i].calls.load(std::memory_order_relaxed);
+            targets[i]->comparisons = ops[i].comparisons.load(std::memory_order_relaxed);
+            targets[i]->nodesVisited = ops[i].nodesVisited.load(std::memory_order_relaxed);
+            targets[i]->rebalances = ops[i].rebalances.load(std::memory_order_relaxed);
+        }
+        out.allocations = allocations.load(std::memory_order_relaxed);
+        out.frees = frees.load(std::memory_order_relaxed);
+        out.rebuilds = rebuilds.load(std::memory_order_relaxed);
+        for (int d = 0; d < BSTStats::DEPTH_BUCKETS; d++)
+            out.lookupDepth[d] = depth[d].load(std::memory_order_relaxed);
+    }
+
+    void reset() {
+        for (Op &o : ops) {
+            o.calls = 0;
+            o.comparisons = 0;
+            o.nodesVisited = 0;
+            o.rebalances = 0;
+        }
+        allocations = 0;
+        frees = 0;
+        rebuilds = 0;
+        for (std::atomic<uint64_t> &d : depth)
+            d = 0;
+    }
+
+private:
+    struct Op {
+        std::atomic<uint64_t> calls{0}, comparisons{0}, nodesVisited{0}, rebalances{0};
+    };
+
+    Op ops[3];
+    std::atomic<uint64_t> allocations{0}, frees{0}, rebuilds{0};
+    std::atomic<uint64_t> depth[BSTStats::DEPTH_BUCKETS] = {};
+#else
+    void record(BSTOp, const BSTTally &) {}
+
+    void rebalanced(BSTOp, bool) {}
+
+    void allocated(uint64_t) {}
+
+    void freed(uint64_t) {}
+
+    void rebuilt() {}
+
+    void snapshot(BSTStats &) const {}
+
+    void reset() {}
+#endif
+};
+
+#endif //PROJECT3_BSTSTATS_H
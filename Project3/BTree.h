@@ -0,0 +1,669 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_BTREE_H
+#define PROJECT3_BTREE_H
+
+#include <algorithm>
+#include <climits>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include "ParallelSort.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BTREE_X86_SIMD 1
+#endif
+
+/**
+ * @class IntBTree - B-tree implementation of the Set ADT for int keys
+ *
+ * Drop-in replacement for BST<int> (has/add/remove/size/traversals) that
+ * keeps up to 31 keys in each node instead of one, so a lookup touches
+ * log16(n) nodes rather than log2(n). A node is 448 bytes, seven 64-byte
+ * aligned cache lines: the 32 key slots fill the first two, the child
+ * pointers four more, so searching a node reads two lines. The position of a
+ * key inside a node is found by comparing it against all slots at once
+ * with AVX2 or SSE2 compares, picked at runtime from what the CPU
+ * supports, with a scalar fallback.
+ *
+ * Traversals visit the keys of a node in ascending order: pre-order
+ * lists a node's keys before its children's, post-order after them.
+ * getLeafCount() and getHeight() count B-tree nodes and levels.
+ */
+class IntBTree {
+public:
+    /**
+     * Simple constructor creates an empty set.
+     */
+    IntBTree();
+
+    /**
+     * Destructor
+     */
+    ~IntBTree();
+
+    /**
+     * Copy constructor creates a copy of the set.
+     * @param other another IntBTree to copy
+     */
+    IntBTree(const IntBTree &other);
+
+    /**
+     * Assignment operator.
+     * Destroys current set and makes a copy of the rhs set.
+     * @param rhs  another IntBTree to copy
+     * @return *this
+     */
+    IntBTree &operator=(const IntBTree &rhs);
+
+    /**
+     * Move constructor takes over other's nodes; other is left empty.
+     */
+    IntBTree(IntBTree &&other) noexcept;
+
+    /**
+     * Move assignment; rhs is left empty.
+     */
+    IntBTree &operator=(IntBTree &&rhs) noexcept;
+
+    /**
+     * Determine if the given key is currently in this set
+     * @param key  possible element of this set
+     * @return     true if key is an element, false otherwise
+     */
+    bool has(int key) const;
+
+    /**
+     * Insert a new element into the set.
+     * If the element was already in the set, this method does nothing.
+     * @param newKey to insert
+     * @post has(newKey) is true
+     */
+    void add(int newKey);
+
+    /**
+     * Remove the given key from this set
+     * @param key  an element (possibly) of this set
+     * @post       has(key) is false
+     */
+    void remove(int key);
+
+    /**
+     * Replace the contents of this set with the keys in [first, last),
+     * in any order and possibly repeated.
+     */
+    template<typename InputIt>
+    void buildFrom(InputIt first, InputIt last);
+
+    /**
+     * Check if this is an empty set.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Count the number of elements in this set. O(1).
+     */
+    int size() const;
+
+    /**
+     * Count the leaf nodes of the B-tree.
+     */
+    int getLeafCount() const;
+
+    /**
+     * Returns the number of levels of the B-tree. O(1).
+     */
+    int getHeight() const;
+
+    /**
+     * Returns a string of elements in ascending order.
+     */
+    std::string getInOrderTraversal() const;
+
+    /**
+     * Returns a string of elements, each node's keys before its children's.
+     */
+    std::string getPreOrderTraversal() const;
+
+    /**
+     * Returns a string of elements, each node's keys after its children's.
+     */
+    std::string getPostOrderTraversal() const;
+
+    /**
+     * Calls visit(key) on every element in ascending order.
+     * @param visit  callable taking int
+     */
+    template<typename Visit>
+    void forEachInOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element, each node's keys before its children's.
+     * @param visit  callable taking int
+     */
+    template<typename Visit>
+    void forEachPreOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element, each node's keys after its children's.
+     * @param visit  callable taking int
+     */
+    template<typename Visit>
+    void forEachPostOrder(Visit visit) const;
+
+    /**
+     * Name of the in-node search in use: "avx2", "sse2" or "scalar".
+     */
+    static const char *searchKind();
+
+private:
+    static const int MIN_DEGREE = 16;
+    static const int MAX_KEYS = 2 * MIN_DEGREE - 1;
+    static const int SLOTS = 2 * MIN_DEGREE;  // MAX_KEYS rounded up to whole vectors
+
+    struct alignas(64) Node {
+        int keys[SLOTS];  // keys[count..SLOTS) hold INT_MAX padding
+        Node *children[SLOTS];
+        int count;
+        bool leaf;
+
+        explicit Node(bool isLeaf) : count(0), leaf(isLeaf) {
+            std::fill(keys, keys + SLOTS, INT_MAX);
+            std::fill(children, children + SLOTS, nullptr);
+        }
+
+        /**
+         * Insert key (and, for internal nodes, the child to its right) at i.
+         */
+        void insertAt(int i, int key, Node *rightChild);
+
+        /**
+         * Erase the key at i and, for internal nodes, the child to its right.
+         */
+        void eraseAt(int i);
+    };
+
+    using RankFn = int (*)(const int *keys, int key);
+
+    Node *root;
+    int elements;
+    int levels;
+
+    /**
+     * Number of keys in node that are less than key, i.e. the index of
+     * the first key >= key. Compares all SLOTS keys without branching.
+     */
+    static int rankInNode(const Node *node, int key) {
+        return rankImpl(node->keys, key);
+    }
+
+    static int rankScalar(const int *keys, int key);
+#ifdef BTREE_X86_SIMD
+    static int rankSSE2(const int *keys, int key);
+    static int rankAVX2(const int *keys, int key);
+#endif
+    static RankFn chooseRank();
+    static const RankFn rankImpl;
+
+    /**
+     * Split the full child at index i of parent around its median key,
+     * which moves up into parent.
+     */
+    static void splitChild(Node *parent, int i);
+
+    /**
+     * Merge child i + 1 of parent and the separating key into child i.
+     */
+    static void mergeChildren(Node *parent, int i);
+
+    /**
+     * Make sure child i of parent has at least MIN_DEGREE keys by
+     * borrowing from a sibling or merging with one.
+     * @return the child that now covers child i's range
+     */
+    static Node *fillChild(Node *parent, int i);
+
+    /**
+     * Helper method to delete a subtree. Recursion depth is the number
+     * of levels, at most 8 for int keys.
+     */
+    static void clear(Node *me);
+
+    /**
+     * Helper method to copy a subtree.
+     */
+    static Node *copy(const Node *me);
+};
+
+inline IntBTree::IntBTree() : root(nullptr), elements(0), levels(0) {
+}
+
+inline IntBTree::~IntBTree() {
+    clear(root);
+}
+
+inline IntBTree::IntBTree(const IntBTree &other)
+        : root(copy(other.root)), elements(other.elements), levels(other.levels) {
+}
+
+inline IntBTree &IntBTree::operator=(const IntBTree &rhs) {
+    if (this != &rhs) {
+        Node *fresh = copy(rhs.root);
+        clear(root);
+        root = fresh;
+        elements = rhs.elements;
+        levels = rhs.levels;
+    }
+    return *this;
+}
+
+inline IntBTree::IntBTree(IntBTree &&other) noexcept
+        : root(other.root), elements(other.elements), levels(other.levels) {
+    other.root = nullptr;
+    other.elements = other.levels = 0;
+}
+
+inline IntBTree &IntBTree::operator=(IntBTree &&rhs) noexcept {
+    if (this != &rhs) {
+        clear(root);
+        root = rhs.root;
+        elements = rhs.elements;
+        levels = rhs.levels;
+        rhs.root = nullptr;
+        rhs.elements = rhs.levels = 0;
+    }
+    return *this;
+}
+
+inline bool IntBTree::has(int key) const {
+    const Node *me = root;
+    while (me != nullptr) {
+        int i = rankInNode(me, key);
+        if (i < me->count && me->keys[i] == key)
+            return true;
+        if (me->leaf)
+            return false;
+        me = me->children[i];
+    }
+    return false;
+}
+
+inline void IntBTree::add(int newKey) {
+    if (root == nullptr) {
+        root = new Node(true);
+        levels = 1;
+    }
+    if (root->count == MAX_KEYS) {
+        Node *newRoot = new Node(false);
+        newRoot->children[0] = root;
+        root = newRoot;
+        splitChild(root, 0);
+        ++levels;
+    }
+    // full children are split on the way down, so the leaf has room
+    Node *me = root;
+    while (true) {
+        int i = rankInNode(me, newKey);
+        if (i < me->count && me->keys[i] == newKey)
+            return; // already an element
+        if (me->leaf) {
+            me->insertAt(i, newKey, nullptr);
+            ++elements;
+            return;
+        }
+        if (me->children[i]->count == MAX_KEYS) {
+            splitChild(me, i);
+            if (newKey == me->keys[i])
+                return;
+            if (newKey > me->keys[i])
+                ++i;
+        }
+        me = me->children[i];
+    }
+}
+
+inline void IntBTree::remove(int key) {
+    Node *me = root;
+    // every node entered below the root has at least MIN_DEGREE keys,
+    // so removing one from a leaf never leaves it underfull
+    while (me != nullptr) {
+        int i = rankInNode(me, key);
+        bool found = i < me->count && me->keys[i] == key;
+        if (me->leaf) {
+            if (found) {
+                me->eraseAt(i);
+                --elements;
+            }
+            break;
+        }
+        if (found) {
+            Node *before = me->children[i], *after = me->children[i + 1];
+            if (before->count >= MIN_DEGREE) {
+                // replace with the predecessor, then delete it below
+                const Node *n = before;
+                while (!n->leaf)
+                    n = n->children[n->count];
+                key = me->keys[i] = n->keys[n->count - 1];
+                me = before;
+            } else if (after->count >= MIN_DEGREE) {
+                const Node *n = after;
+                while (!n->leaf)
+                    n = n->children[0];
+                key = me->keys[i] = n->keys[0];
+                me = after;
+            } else {
+                mergeChildren(me, i);
+                me = before;
+            }
+        } else {
+            me = fillChild(me, i);
+        }
+    }
+    if (root != nullptr && root->count == 0) {
+        Node *oldRoot = root;
+        root = root->leaf ? nullptr : root->children[0];
+        delete oldRoot;
+        --levels;
+    }
+}
+
+template<typename InputIt>
+void IntBTree::buildFrom(InputIt first, InputIt last) {
+    std::vector<int> keys(first, last);
+    parallelSort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    clear(root);
+    root = nullptr;
+    elements = levels = 0;
+    for (int key : keys)
+        add(key);
+}
+
+inline bool IntBTree::isEmpty() const {
+    return elements == 0;
+}
+
+inline int IntBTree::size() const {
+    return elements;
+}
+
+inline int IntBTree::getLeafCount() const {
+    int leaves = 0;
+    std::vector<const Node *> todo;
+    if (root != nullptr)
+        todo.push_back(root);
+    while (!todo.empty()) {
+        const Node *n = todo.back();
+        todo.pop_back();
+        if (n->leaf) {
+            ++leaves;
+            continue;
+        }
+        for (int i = 0; i <= n->count; i++)
+            todo.push_back(n->children[i]);
+    }
+    return leaves;
+}
+
+inline int IntBTree::getHeight() const {
+    return levels;
+}
+
+inline std::string IntBTree::getInOrderTraversal() const {
+    std::ostringstream ss;
+    forEachInOrder([&ss](int key) { ss << key << " "; });
+    return ss.str();
+}
+
+inline std::string IntBTree::getPreOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPreOrder([&ss](int key) { ss << key << " "; });
+    return ss.str();
+}
+
+inline std::string IntBTree::getPostOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPostOrder([&ss](int key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename Visit>
+void IntBTree::forEachInOrder(Visit visit) const {
+    // (node, index of the next child to descend into)
+    std::vector<std::pair<const Node *, int>> todo;
+    todo.reserve(levels);
+    if (root != nullptr)
+        todo.emplace_back(root, 0);
+    while (!todo.empty()) {
+        const Node *n = todo.back().first;
+        int i = todo.back().second;
+        if (n->leaf) {
+            for (int j = 0; j < n->count; j++)
+                visit(n->keys[j]);
+            todo.pop_back();
+        } else if (i <= n->count) {
+            if (i > 0)
+                visit(n->keys[i - 1]);
+            todo.back().second = i + 1;
+            todo.emplace_back(n->children[i], 0);
+        } else {
+            todo.pop_back();
+        }
+    }
+}
+
+template<typename Visit>
+void IntBTree::forEachPreOrder(Visit visit) const {
+    std::vector<const Node *> todo;
+    if (root != nullptr)
+        todo.push_back(root);
+    while (!todo.empty()) {
+        const Node *n = todo.back();
+        todo.pop_back();
+        for (int j = 0; j < n->count; j++)
+            visit(n->keys[j]);
+        if (!n->leaf)
+            for (int i = n->count; i >= 0; i--)
+                todo.push_back(n->children[i]);
+    }
+}
+
+template<typename Visit>
+void IntBTree::forEachPostOrder(Visit visit) const {
+    std::vector<std::pair<const Node *, int>> todo;
+    todo.reserve(levels);
+    if (root != nullptr)
+        todo.emplace_back(root, 0);
+    while (!todo.empty()) {
+        const Node *n = todo.back().first;
+        int i = todo.back().second;
+        if (!n->leaf && i <= n->count) {
+            todo.back().second = i + 1;
+            todo.emplace_back(n->children[i], 0);
+        } else {
+            for (int j = 0; j < n->count; j++)
+                visit(n->keys[j]);
+            todo.pop_back();
+        }
+    }
+}
+
+inline const char *IntBTree::searchKind() {
+#ifdef BTREE_X86_SIMD
+    if (rankImpl == rankAVX2)
+        return "avx2";
+    if (rankImpl == rankSSE2)
+        return "sse2";
+#endif
+    return "scalar";
+}
+
+inline void IntBTree::Node::insertAt(int i, int key, Node *rightChild) {
+    std::copy_backward(keys + i, keys + count, keys + count + 1);
+    keys[i] = key;
+    if (!leaf) {
+        std::copy_backward(children + i + 1, children + count + 1, children + count + 2);
+        children[i + 1] = rightChild;
+    }
+    ++count;
+}
+
+inline void IntBTree::Node::eraseAt(int i) {
+    std::copy(keys + i + 1, keys + count, keys + i);
+    if (!leaf) {
+        std::copy(children + i + 2, children + count + 1, children + i + 1);
+        children[count] = nullptr;
+    }
+    --count;
+    keys[count] = INT_MAX;
+}
+
+inline int IntBTree::rankScalar(const int *keys, int key) {
+    int rank = 0;
+    for (int i = 0; i < SLOTS; i++)
+        rank += keys[i] < key;
+    return rank;
+}
+
+#ifdef BTREE_X86_SIMD
+inline int IntBTree::rankSSE2(const int *keys, int key) {
+    __m128i needle = _mm_set1_epi32(key);
+    int rank = 0;
+    for (int i = 0; i < SLOTS; i += 4) {
+        __m128i block = _mm_load_si128(reinterpret_cast<const __m128i *>(keys + i));
+        __m128i less = _mm_cmpgt_epi32(needle, block);
+        rank += __builtin_popcount(_mm_movemask_ps(_mm_castsi128_ps(less)));
+    }
+    return rank;
+}
+
+__attribute__((target("avx2")))
+inline int IntBTree::rankAVX2(const int *keys, int key) {
+    __m256i needle = _mm256_set1_epi32(key);
+    int rank = 0;
+    for (int i = 0; i < SLOTS; i += 8) {
+        __m256i block = _mm256_load_si256(reinterpret_cast<const __m256i *>(keys + i));
+        __m256i less = _mm256_cmpgt_epi32(needle, block);
+        rank += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(less)));
+    }
+    return rank;
+}
+#endif
+
+inline IntBTree::RankFn IntBTree::chooseRank() {
+#ifdef BTREE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return rankAVX2;
+    return rankSSE2;
+#else
+    return rankScalar;
+#endif
+}
+
+inline const IntBTree::RankFn IntBTree::rankImpl = IntBTree::chooseRank();
+
+inline void IntBTree::splitChild(Node *parent, int i) {
+    Node *full = parent->children[i];
+    Node *sibling = new Node(full->leaf);
+    sibling->count = MIN_DEGREE - 1;
+    std::copy(full->keys + MIN_DEGREE, full->keys + MAX_KEYS, sibling->keys);
+    if (!full->leaf) {
+        std::copy(full->children + MIN_DEGREE, full->children + MAX_KEYS + 1, sibling->children);
+        std::fill(full->children + MIN_DEGREE, full->children + MAX_KEYS + 1, nullptr);
+    }
+    int median = full->keys[MIN_DEGREE - 1];
+    std::fill(full->keys + MIN_DEGREE - 1, full->keys + MAX_KEYS, INT_MAX);
+    full->count = MIN_DEGREE - 1;
+    parent->insertAt(i, median, sibling);
+}
+
+inline void IntBTree::mergeChildren(Node *parent, int i) {
+    Node *left = parent->children[i];
+    Node *right = parent->children[i + 1];
+    left->keys[left->count] = parent->keys[i];
+    std::copy(right->keys, right->keys + right->count, left->keys + left->count + 1);
+    if (!left->leaf)
+        std::copy(right->children, right->children + right->count + 1, left->children + left->count + 1);
+    left->count += right->count + 1;
+    parent->eraseAt(i);
+    delete right;
+}
+
+inline IntBTree::Node *IntBTree::fillChild(Node *parent, int i) {
+    Node *child = parent->children[i];
+    if (child->count >= MIN_DEGREE)
+        return child;
+
+    if (i > 0 && parent->children[i - 1]->count >= MIN_DEGREE) {
+        // rotate the left sibling's largest key through the parent
+        Node *left = parent->children[i - 1];
+        Node *moved = left->leaf ? nullptr : left->children[left->count];
+        std::copy_backward(child->keys, child->keys + child->count, child->keys + child->count + 1);
+        child->keys[0] = parent->keys[i - 1];
+        if (!child->leaf) {
+            std::copy_backward(child->children, child->children + child->count + 1,
+                               child->children + child->count + 2);
+            child->children[0] = moved;
+        }
+        ++child->count;
+        parent->keys[i - 1] = left->keys[left->count - 1];
+        if (!left->leaf)
+            left->children[left->count] = nullptr;
+        --left->count;
+        left->keys[left->count] = INT_MAX;
+        return child;
+    }
+
+    if (i < parent->count && parent->children[i + 1]->count >= MIN_DEGREE) {
+        // rotate the right sibling's smallest key through the parent
+        Node *right = parent->children[i + 1];
+        Node *moved = right->leaf ? nullptr : right->children[0];
+        child->keys[child->count] = parent->keys[i];
+        if (!child->leaf)
+            child->children[child->count + 1] = moved;
+        ++child->count;
+        parent->keys[i] = right->keys[0];
+        std::copy(right->keys + 1, right->keys + right->count, right->keys);
+        if (!right->leaf) {
+            std::copy(right->children + 1, right->children + right->count + 1, right->children);
+            right->children[right->count] = nullptr;
+        }
+        --right->count;
+        right->keys[right->count] = INT_MAX;
+        return child;
+    }
+
+    if (i < parent->count) {
+        mergeChildren(parent, i);
+        return child;
+    }
+    mergeChildren(parent, i - 1);
+    return parent->children[i - 1];
+}
+
+inline void IntBTree::clear(Node *me) {
+    if (me == nullptr)
+        return;
+    if (!me->leaf)
+        for (int i = 0; i <= me->count; i++)
+            clear(me->children[i]);
+    delete me;
+}
+
+inline IntBTree::Node *IntBTree::copy(const Node *me) {
+    if (me == nullptr)
+        return nullptr;
+    Node *n = new Node(me->leaf);
+    n->count = me->count;
+    std::copy(me->keys, me->keys + SLOTS, n->keys);
+    if (!me->leaf)
+        for (int i = 0; i <= me->count; i++)
+            n->children[i] = copy(me->children[i]);
+    return n;
+}
+
+#endif //PROJECT3_BTREE_H
@@ -0,0 +1,386 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_CONCURRENTBST_H
+#define PROJECT3_CONCURRENTBST_H
+
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <vector>
+#include "Epoch.h"
+
+/**
+ * @class ConcurrentBST - Set ADT safe to share between threads
+ *
+ * has(), the traversals and the shape queries take no lock: readers
+ * follow atomically published child links inside an epoch guard. add()
+ * and remove() are serialized by a writer mutex, but never block
+ * readers. A writer only ever changes the tree by storing a single link:
+ * a new leaf, a spliced-out node, or (when removing a node with two
+ * children) a fresh copy of the path from that node down to its
+ * successor. So a reader sees each key either before or after an update,
+ * never a half-finished one, and nodes a reader may still hold are freed
+ * through EpochDomain once no reader can reach them.
+ *
+ * The tree is not rebalanced; rotations would have to copy their whole
+ * neighbourhood to stay invisible to readers.
+ *
+ * Traversals are weakly consistent: keys present for the whole traversal
+ * are listed exactly once, keys added or removed meanwhile may or may not
+ * be.
+ */
+template<typename KeyType>
+class ConcurrentBST {
+public:
+    /**
+     * Simple constructor creates an empty set.
+     */
+    ConcurrentBST();
+
+    /**
+     * Destructor. No other thread may be using the set.
+     */
+    ~ConcurrentBST();
+
+    ConcurrentBST(const ConcurrentBST &) = delete;
+
+    ConcurrentBST &operator=(const ConcurrentBST &) = delete;
+
+    /**
+     * Determine if the given key is currently in this set. Lock-free.
+     * @param key  possible element of this set
+     * @return     true if key is an element, false otherwise
+     */
+    bool has(const KeyType &key) const;
+
+    /**
+     * Insert a new element into the set.
+     * If the element was already in the set, this method does nothing.
+     * @param newKey to insert
+     * @post has(newKey) is true
+     */
+    void add(const KeyType &newKey);
+
+    /**
+     * Remove the given key from this set
+     * @param key  an element (possibly) of this set
+     * @post       has(key) is false
+     */
+    void remove(const KeyType &key);
+
+    /**
+     * Check if this is an empty set.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Count the number of elements in this set. O(1).
+     */
+    int size() const;
+
+    /**
+     * Count the leaves of the tree. Lock-free, O(n).
+     */
+    int getLeafCount() const;
+
+    /**
+     * Returns the height of the tree. Lock-free, O(n).
+     */
+    int getHeight() const;
+
+    std::string getInOrderTraversal() const;
+
+    std::string getPreOrderTraversal() const;
+
+    std::string getPostOrderTraversal() const;
+
+    /**
+     * Calls visit(key) on every element in strictly ascending order, even
+     * while writers run. Lock-free.
+     * @param visit  callable taking const KeyType &
+     */
+    template<typename Visit>
+    void forEachInOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in pre-order order. Lock-free.
+     */
+    template<typename Visit>
+    void forEachPreOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in post-order order. Lock-free.
+     */
+    template<typename Visit>
+    void forEachPostOrder(Visit visit) const;
+
+private:
+    struct Node {
+        const KeyType key;
+        std::atomic<Node *> left, right;
+
+        explicit Node(const KeyType &newKey, Node *lch = nullptr, Node *rch = nullptr)
+                : key(newKey), left(lch), right(rch) {}
+    };
+
+    std::atomic<Node *> root;
+    std::atomic<int> count;
+    std::mutex writeLock;
+
+    static Node *load(const std::atomic<Node *> &link) {
+        return link.load(std::memory_order_acquire);
+    }
+
+    static void publish(std::atomic<Node *> &link, Node *n) {
+        link.store(n, std::memory_order_release);
+    }
+
+    /**
+     * Height of the subtree under me, using an explicit stack.
+     */
+    static int height(const Node *me);
+};
+
+template<typename KeyType>
+ConcurrentBST<KeyType>::ConcurrentBST() : root(nullptr), count(0) {
+}
+
+template<typename KeyType>
+ConcurrentBST<KeyType>::~ConcurrentBST() {
+    std::vector<Node *> todo;
+    if (Node *r = root.load())
+        todo.push_back(r);
+    while (!todo.empty()) {
+        Node *n = todo.back();
+        todo.pop_back();
+        if (Node *l = n->left.load())
+            todo.push_back(l);
+        if (Node *r = n->right.load())
+            todo.push_back(r);
+        delete n;
+    }
+}
+
+template<typename KeyType>
+bool ConcurrentBST<KeyType>::has(const KeyType &key) const {
+    EpochDomain::Guard guard;
+    const Node *me = load(root);
+    while (me != nullptr) {
+        if (key < me->key)
+            me = load(me->left);
+        else if (key > me->key)
+            me = load(me->right);
+        else
+            return true;
+    }
+    return false;
+}
+
+template<typename KeyType>
+void ConcurrentBST<KeyType>::add(const KeyType &newKey) {
+    std::lock_guard<std::mutex> lock(writeLock);
+    std::atomic<Node *> *link = &root;
+    while (Node *me = link->load(std::memory_order_relaxed)) {
+        if (newKey < me->key)
+            link = &me->left;
+        else if (newKey > me->key)
+            link = &me->right;
+        else
+            return; // already an element
+    }
+    publish(*link, new Node(newKey));
+    count.fetch_add(1, std::memory_order_relaxed);
+}
+
+template<typename KeyType>
+void ConcurrentBST<KeyType>::remove(const KeyType &key) {
+    std::lock_guard<std::mutex> lock(writeLock);
+    EpochDomain &epochs = EpochDomain::global();
+    std::atomic<Node *> *link = &root;
+    Node *target;
+    while ((target = link->load(std::memory_order_relaxed)) != nullptr) {
+        if (key < target->key)
+            link = &target->left;
+        else if (key > target->key)
+            link = &target->right;
+        else
+            break;
+    }
+    if (target == nullptr)
+        return; // not an element
+
+    Node *left = target->left.load(std::memory_order_relaxed);
+    Node *right = target->right.load(std::memory_order_relaxed);
+    if (left == nullptr || right == nullptr) {
+        publish(*link, left == nullptr ? right : left);
+        epochs.retire(target);
+    } else {
+        // Copy the path from right down to my successor, leaving the
+        // successor out, then publish my successor's key in my place in
+        // one store. Readers already inside the old path keep seeing it
+        // unchanged until they leave.
+        std::vector<Node *> path;
+        for (Node *n = right; n != nullptr; n = n->left.load(std::memory_order_relaxed))
+            path.push_back(n);
+        Node *successor = path.back();
+        Node *fresh = successor->right.load(std::memory_order_relaxed);
+        for (size_t i = path.size() - 1; i-- > 0;)
+            fresh = new Node(path[i]->key, fresh, path[i]->right.load(std::memory_order_relaxed));
+        publish(*link, new Node(successor->key, left, fresh));
+
+        epochs.retire(target);
+        for (Node *n : path)
+            epochs.retire(n);
+    }
+    count.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template<typename KeyType>
+bool ConcurrentBST<KeyType>::isEmpty() const {
+    return size() == 0;
+}
+
+template<typename KeyType>
+int ConcurrentBST<KeyType>::size() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+template<typename KeyType>
+int ConcurrentBST<KeyType>::getLeafCount() const {
+    EpochDomain::Guard guard;
+    int leaves = 0;
+    std::vector<const Node *> todo;
+    if (const Node *r = load(root))
+        todo.push_back(r);
+    while (!todo.empty()) {
+        const Node *n = todo.back();
+        todo.pop_back();
+        const Node *l = load(n->left), *r = load(n->right);
+        if (l == nullptr && r == nullptr)
+            ++leaves;
+        if (l != nullptr)
+            todo.push_back(l);
+        if (r != nullptr)
+            todo.push_back(r);
+    }
+    return leaves;
+}
+
+template<typename KeyType>
+int ConcurrentBST<KeyType>::getHeight() const {
+    EpochDomain::Guard guard;
+    return height(load(root));
+}
+
+template<typename KeyType>
+int ConcurrentBST<KeyType>::height(const Node *me) {
+    int best = 0;
+    std::vector<std::pair<const Node *, int>> todo;
+    if (me != nullptr)
+        todo.emplace_back(me, 1);
+    while (!todo.empty()) {
+        const Node *n = todo.back().first;
+        int depth = todo.back().second;
+        todo.pop_back();
+        if (depth > best)
+            best = depth;
+        if (const Node *l = load(n->left))
+            todo.emplace_back(l, depth + 1);
+        if (const Node *r = load(n->right))
+            todo.emplace_back(r, depth + 1);
+    }
+    return best;
+}
+
+template<typename KeyType>
+std::string ConcurrentBST<KeyType>::getInOrderTraversal() const {
+    std::ostringstream ss;
+    forEachInOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType>
+std::string ConcurrentBST<KeyType>::getPreOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPreOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType>
+std::string ConcurrentBST<KeyType>::getPostOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPostOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType>
+template<typename Visit>
+void ConcurrentBST<KeyType>::forEachInOrder(Visit visit) const {
+    EpochDomain::Guard guard;
+    std::vector<const Node *> todo;
+    const Node *me = load(root);
+    // A node on the stack may have been removed and replaced by its
+    // successor meanwhile, and keys between the two can then be added to
+    // the left subtree we are still walking. Such a stale node would come
+    // out of order, so anything not above the last key visited is dropped.
+    const KeyType *last = nullptr;
+    while (me != nullptr || !todo.empty()) {
+        while (me != nullptr) {
+            todo.push_back(me);
+            me = load(me->left);
+        }
+        me = todo.back();
+        todo.pop_back();
+        if (last == nullptr || *last < me->key) {
+            visit(me->key);
+            last = &me->key;
+        }
+        me = load(me->right);
+    }
+}
+
+template<typename KeyType>
+template<typename Visit>
+void ConcurrentBST<KeyType>::forEachPreOrder(Visit visit) const {
+    EpochDomain::Guard guard;
+    std::vector<const Node *> todo;
+    if (const Node *r = load(root))
+        todo.push_back(r);
+    while (!todo.empty()) {
+        const Node *me = todo.back();
+        todo.pop_back();
+        visit(me->key);
+        if (const Node *r = load(me->right))
+            todo.push_back(r);
+        if (const Node *l = load(me->left))
+            todo.push_back(l);
+    }
+}
+
+template<typename KeyType>
+template<typename Visit>
+void ConcurrentBST<KeyType>::forEachPostOrder(Visit visit) const {
+    EpochDomain::Guard guard;
+    // (node, its right child as read when the node was first reached)
+    std::vector<std::pair<const Node *, const Node *>> todo;
+    const Node *me = load(root), *lastVisited = nullptr;
+    while (me != nullptr || !todo.empty()) {
+        if (me != nullptr) {
+            todo.emplace_back(me, load(me->right));
+            me = load(me->left);
+        } else {
+            const Node *right = todo.back().second;
+            if (right != nullptr && right != lastVisited) {
+                me = right;
+            } else {
+                visit(todo.back().first->key);
+                lastVisited = todo.back().first;
+                todo.pop_back();
+            }
+        }
+    }
+}
+
+#endif //PROJECT3_CONCURRENTBST_H
@@ -0,0 +1,224 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_EPOCH_H
+#define PROJECT3_EPOCH_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * @class EpochDomain - epoch-based memory reclamation
+ *
+ * Readers pin the current epoch with an EpochDomain::Guard for as long as
+ * they hold pointers into a shared structure. A writer that unlinks a
+ * node hands it to retire() instead of deleting it; the node is freed
+ * once the global epoch has advanced twice past the epoch it was retired
+ * in, which can only happen after every reader that might have seen it
+ * has dropped its guard.
+ *
+ * Each thread owns one record, claimed on its first guard and handed back
+ * when the thread exits. Guards nest.
+ */
+class EpochDomain {
+public:
+    /**
+     * Pins the calling thread to the current epoch for its lifetime.
+     */
+    class Guard {
+    public:
+        explicit Guard(EpochDomain &domain = EpochDomain::global());
+
+        ~Guard();
+
+        Guard(const Guard &) = delete;
+
+        Guard &operator=(const Guard &) = delete;
+
+    private:
+        EpochDomain &domain;
+    };
+
+    /**
+     * The domain shared by all concurrent trees in the process.
+     */
+    static EpochDomain &global();
+
+    EpochDomain() = default;
+
+    /**
+     * Frees everything still waiting; no guards may be held.
+     */
+    ~EpochDomain();
+
+    EpochDomain(const EpochDomain &) = delete;
+
+    EpochDomain &operator=(const EpochDomain &) = delete;
+
+    /**
+     * Schedule p to be freed by deleter(p) once no reader can hold it.
+     * p must already be unreachable for readers that pin from now on.
+     */
+    void retire(void *p, void (*deleter)(void *));
+
+    /**
+     * Convenience overload deleting a T with delete.
+     */
+    template<typename T>
+    void retire(T *p) {
+        retire(p, [](void *q) { delete static_cast<T *>(q); });
+    }
+
+    /**
+     * Try to advance the epoch and free what has become safe. Called
+     * automatically every RECLAIM_INTERVAL retirements.
+     */
+    void tryReclaim();
+
+private:
+    struct Record {
+        std::atomic<uint64_t> local{0};
+        std::atomic<bool> active{false};
+        std::atomic<bool> inUse{true};
+        int nesting = 0;
+        Record *next = nullptr;
+    };
+
+    struct Retired {
+        void *p;
+        void (*deleter)(void *);
+    };
+
+    static const size_t RECLAIM_INTERVAL = 256;
+
+    std::atomic<uint64_t> epoch{0};
+    std::atomic<Record *> records{nullptr};
+    std::mutex limboLock;
+    std::vector<Retired> limbo[3];  // indexed by retire epoch mod 3
+    size_t sinceReclaim = 0;
+
+    /**
+     * The calling thread's record, claiming a free one or adding a new
+     * one on first use.
+     */
+    Record *threadRecord();
+
+    void pin();
+
+    void unpin();
+
+    /**
+     * Advance the epoch if every pinned thread has caught up with it, and
+     * free the bucket that became safe. Caller holds limboLock.
+     */
+    void advanceLocked();
+};
+
+inline EpochDomain::Guard::Guard(EpochDomain &domain) : domain(domain) {
+    domain.pin();
+}
+
+inline EpochDomain::Guard::~Guard() {
+    domain.unpin();
+}
+
+inline EpochDomain &EpochDomain::global() {
+    static EpochDomain domain;
+    return domain;
+}
+
+inline EpochDomain::~EpochDomain() {
+    for (std::vector<Retired> &bucket : limbo)
+        for (Retired &r : bucket)
+            r.deleter(r.p);
+    Record *rec = records.load();
+    while (rec != nullptr) {
+        Record *next = rec->next;
+        delete rec;
+        rec = next;
+    }
+}
+
+inline void EpochDomain::retire(void *p, void (*deleter)(void *)) {
+    std::lock_guard<std::mutex> lock(limboLock);
+    limbo[epoch.load() % 3].push_back(Retired{p, deleter});
+    if (++sinceReclaim >= RECLAIM_INTERVAL) {
+        sinceReclaim = 0;
+        advanceLocked();
+    }
+}
+
+inline void EpochDomain::tryReclaim() {
+    std::lock_guard<std::mutex> lock(limboLock);
+    advanceLocked();
+}
+
+inline void EpochDomain::advanceLocked() {
+    uint64_t current = epoch.load();
+    for (Record *rec = records.load(); rec != nullptr; rec = rec->next)
+        if (rec->active.load() && rec->local.load() != current)
+            return; // somebody is still reading in an older epoch
+    epoch.store(current + 1);
+    // retired in current - 2: nobody pinned that early is left
+    std::vector<Retired> safe;
+    safe.swap(limbo[(current + 1) % 3]);
+    for (Retired &r : safe)
+        r.deleter(r.p);
+}
+
+inline EpochDomain::Record *EpochDomain::threadRecord() {
+    // the records this thread holds, one per domain; handed back when
+    // the thread exits
+    struct Registrations {
+        std::vector<std::pair<EpochDomain *, Record *>> held;
+
+        ~Registrations() {
+            for (auto &entry : held)
+                entry.second->inUse.store(false);
+        }
+    };
+    thread_local Registrations registrations;
+    for (auto &entry : registrations.held)
+        if (entry.first == this)
+            return entry.second;
+
+    Record *rec = nullptr;
+    for (Record *r = records.load(); r != nullptr && rec == nullptr; r = r->next) {
+        bool expected = false;
+        if (r->inUse.compare_exchange_strong(expected, true))
+            rec = r;
+    }
+    if (rec == nullptr) {
+        rec = new Record;
+        Record *head = records.load();
+        do {
+            rec->next = head;
+        } while (!records.compare_exchange_weak(head, rec));
+    }
+    registrations.held.emplace_back(this, rec);
+    return rec;
+}
+
+inline void EpochDomain::pin() {
+    Record *rec = threadRecord();
+    if (rec->nesting++ > 0)
+        return;
+    rec->local.store(epoch.load());
+    rec->active.store(true);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    // the epoch may have moved between the load and the store above
+    rec->local.store(epoch.load());
+}
+
+inline void EpochDomain::unpin() {
+    Record *rec = threadRecord();
+    if (--rec->nesting == 0)
+        rec->active.store(false, std::memory_order_release);
+}
+
+#endif //PROJECT3_EPOCH_H
@@ -0,0 +1,56 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_EYTZINGER_H
+#define PROJECT3_EYTZINGER_H
+
+#include <cstddef>
+
+/**
+ * @file Eytzinger.h - index arithmetic for implicit trees stored in
+ * Eytzinger (BFS) order: the root is slot 1 and the children of slot k
+ * are slots 2k and 2k + 1, for slots 1..n.
+ */
+
+/**
+ * Slot of the smallest element of an n-slot tree, or 0 if n is 0.
+ */
+inline std::size_t eytzingerFirst(std::size_t n) {
+    if (n == 0)
+        return 0;
+    std::size_t k = 1;
+    while (2 * k <= n)
+        k *= 2;
+    return k;
+}
+
+/**
+ * Slot of the in-order successor of slot k, or 0 after the largest.
+ */
+inline std::size_t eytzingerNext(std::size_t k, std::size_t n) {
+    if (2 * k + 1 <= n) {
+        k = 2 * k + 1;
+        while (2 * k <= n)
+            k *= 2;
+    } else {
+        while (k & 1)
+            k >>= 1;
+        k >>= 1;
+    }
+    return k;
+}
+
+/**
+ * Finish a descent that went left at slot k when the key was not above
+ * slot k and right otherwise, until it fell off the tree: undoes the
+ * trailing right turns plus the last left turn.
+ * @return  slot of the smallest element >= the key, or 0 if none
+ */
+inline std::size_t eytzingerLowerBound(std::size_t k) {
+    while (k & 1)
+        k >>= 1;
+    return k >> 1;
+}
+
+#endif //PROJECT3_EYTZINGER_H
@@ -0,0 +1,164 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_FASTPARSE_H
+#define PROJECT3_FASTPARSE_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/**
+ * @file FastParse.h - tokenizing and number parsing for the key files,
+ * without iostreams: the file is mapped, tokens are handed out as
+ * std::string_view into the mapping and integers are converted with
+ * std::from_chars (no locale, no virtual calls, no allocation).
+ *
+ * A separator is any byte <= ' ' (space, tab, newline, carriage return
+ * and the other control characters); a token is a maximal run of other
+ * bytes.
+ */
+
+/**
+ * @class MappedFile - a whole file mapped read-only
+ */
+class MappedFile {
+public:
+    /**
+     * Map the file at path. isOpen() tells whether that worked.
+     */
+    explicit MappedFile(const char *path) : data(nullptr), length(0), opened(false) {
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0)
+            return;
+        struct stat info{};
+        if (::fstat(fd, &info) == 0) {
+            length = static_cast<size_t>(info.st_size);
+            if (length == 0) {
+                opened = true;
+            } else {
+                void *p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    ::madvise(p, length, MADV_SEQUENTIAL);
+                    data = static_cast<const char *>(p);
+                    opened = true;
+                }
+            }
+        }
+        ::close(fd);
+    }
+
+    ~MappedFile() {
+        if (data != nullptr)
+            ::munmap(const_cast<char *>(data), length);
+    }
+
+    MappedFile(const MappedFile &) = delete;
+
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool isOpen() const {
+        return opened;
+    }
+
+    /**
+     * The file's contents; valid while this object lives.
+     */
+    std::string_view text() const {
+        return std::string_view(data, data == nullptr ? 0 : length);
+    }
+
+private:
+    const char *data;
+    size_t length;
+    bool opened;
+};
+
+/**
+ * Calls visit(token) for every token of text, in order. With SSE2 the
+ * separators of 16 bytes at a time are found with one compare, and the
+ * token boundaries are then read off the bit mask.
+ * @param text   bytes to split
+ * @param visit  callable taking std::string_view
+ */
+template<typename Visit>
+void forEachToken(std::string_view text, Visit visit) {
+    const char *p = text.data(), *end = p + text.size();
+    const char *start = nullptr;   // of the token being read, if any
+#if defined(__SSE2__)
+    const __m128i space = _mm_set1_epi8(' ');
+    for (; end - p >= 16; p += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        // max(byte, ' ') == ' ' exactly for the bytes <= ' ' (unsigned)
+        uint32_t separators = static_cast<uint32_t>(
+                _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(chunk, space), space)));
+        uint32_t others = ~separators & 0xFFFF;
+        int i = 0;
+        while (i < 16) {
+            if (start != nullptr) {
+                uint32_t rest = separators >> i;
+                if (rest == 0)
+                    break; // the token runs on into the next block
+                i += __builtin_ctz(rest);
+                visit(std::string_view(start, static_cast<size_t>(p + i - start)));
+                start = nullptr;
+            } else {
+                uint32_t rest = others >> i;
+                if (rest == 0)
+                    break;
+                i += __builtin_ctz(rest);
+                start = p + i;
+            }
+        }
+    }
+#endif
+    for (; p < end; ++p) {
+        bool separator = static_cast<unsigned char>(*p) <= ' ';
+        if (start != nullptr && separator) {
+            visit(std::string_view(start, static_cast<size_t>(p - start)));
+            start = nullptr;
+        } else if (start == nullptr && !separator) {
+            start = p;
+        }
+    }
+    if (start != nullptr)
+        visit(std::string_view(start, static_cast<size_t>(end - start)));
+}
+
+/**
+ * Append the ints in text to out, reading tokens the way `stream >> int`
+ * does: an optional sign, then decimal digits. Reading stops at the first
+ * token that is not entirely such a number; a number it starts with is
+ * still appended, unless it does not fit in an int, and nothing after it
+ * is read.
+ * @return  true if every token was a number, false if reading stopped early
+ */
+inline bool parseInts(std::string_view text, std::vector<int> &out) {
+    bool stopped = false;
+    forEachToken(text, [&out, &stopped](std::string_view token) {
+        if (stopped)
+            return;
+        const char *first = token.data(), *last = first + token.size();
+        if (*first == '+' && last - first > 1 && first[1] != '-')
+            ++first;
+        int value;
+        std::from_chars_result parsed = std::from_chars(first, last, value);
+        if (parsed.ec == std::errc())
+            out.push_back(value);
+        stopped = parsed.ec != std::errc() || parsed.ptr != last;
+    });
+    return !stopped;
+}
+
+#endif //PROJECT3_FASTPARSE_H
@@ -0,0 +1,310 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_FINEGRAINEDBST_H
+#define PROJECT3_FINEGRAINEDBST_H
+
+#include <atomic>
+#include <cstdint>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include "Epoch.h"
+
+/**
+ * @class FineGrainedBST - Set ADT for many concurrent writers
+ *
+ * An external (leaf-oriented) search tree: keys live in the leaves and
+ * the internal nodes only route, with keys smaller than the router on
+ * the left. That makes every update a single link change:
+ *  - add() replaces a leaf by a router over the old leaf and the new one;
+ *  - remove() replaces the leaf's parent by the leaf's sibling.
+ *
+ * has() and the traversals take no lock. An update searches without
+ * locks too, then locks only the nodes whose links it will change (the
+ * parent for add(), grandparent and parent for remove()), checks they
+ * are still linked as it saw them and retries otherwise. Writers on
+ * different parts of the tree therefore never wait for each other.
+ * Unlinked nodes are freed through EpochDomain.
+ *
+ * has(), add() and remove() are linearizable. The tree is not
+ * rebalanced. KeyType must be default constructible (the two sentinel
+ * leaves hold KeyType()).
+ *
+ * Only the set operations of BST are provided: has/add/remove, isEmpty,
+ * size and the in-order traversals. getHeight, getLeafCount and the
+ * pre/post-order traversals are left out on purpose: every key is a leaf
+ * here and the routers repeat keys, so they would not describe the same
+ * shape as a BST's and could not be compared with one. The set therefore
+ * does not fit testIntBST or the bench ops matrix; its cost is measured
+ * by the concurrent and writers suites, whose threads=1 rows give the
+ * single-caller cost.
+ */
+template<typename KeyType>
+class FineGrainedBST {
+public:
+    /**
+     * Simple constructor creates an empty set.
+     */
+    FineGrainedBST();
+
+    /**
+     * Destructor. No other thread may be using the set.
+     */
+    ~FineGrainedBST();
+
+    FineGrainedBST(const FineGrainedBST &) = delete;
+
+    FineGrainedBST &operator=(const FineGrainedBST &) = delete;
+
+    /**
+     * Determine if the given key is currently in this set. Lock-free.
+     * @param key  possible element of this set
+     * @return     true if key is an element, false otherwise
+     */
+    bool has(const KeyType &key) const;
+
+    /**
+     * Insert a new element into the set.
+     * If the element was already in the set, this method does nothing.
+     * @param newKey to insert
+     * @post has(newKey) is true
+     */
+    void add(const KeyType &newKey);
+
+    /**
+     * Remove the given key from this set
+     * @param key  an element (possibly) of this set
+     * @post       has(key) is false
+     */
+    void remove(const KeyType &key);
+
+    /**
+     * Check if this is an empty set.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Count the number of elements in this set. O(1).
+     */
+    int size() const;
+
+    std::string getInOrderTraversal() const;
+
+    /**
+     * Calls visit(key) on every element in ascending order. Lock-free and
+     * weakly consistent: keys present for the whole traversal are listed
+     * exactly once, keys added or removed meanwhile may or may not be.
+     * @param visit  callable taking const KeyType &
+     */
+    template<typename Visit>
+    void forEachInOrder(Visit visit) const;
+
+private:
+    /**
+     * Test-and-test-and-set lock; yields while waiting since a holder
+     * only keeps it for a couple of stores.
+     */
+    class SpinLock {
+    public:
+        void lock() {
+            while (held.exchange(true, std::memory_order_acquire))
+                while (held.load(std::memory_order_relaxed))
+                    std::this_thread::yield();
+        }
+
+        void unlock() {
+            held.store(false, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<bool> held{false};
+    };
+
+    struct Node {
+        const KeyType key;
+        // 0 for a real key, 1 and 2 for the sentinels, which compare
+        // above every key and 1 < 2
+        const uint8_t infinity;
+        const bool leaf;
+        bool removed = false;   // unlinked router; guarded by lock
+        std::atomic<Node *> left{nullptr}, right{nullptr};
+        SpinLock lock;
+
+        Node(const KeyType &newKey, uint8_t inf, bool isLeaf) : key(newKey), infinity(inf), leaf(isLeaf) {}
+
+        /**
+         * Is key routed to my left?
+         */
+        bool before(const KeyType &k) const {
+            return infinity > 0 || k < key;
+        }
+
+        std::atomic<Node *> &childFor(const KeyType &k) {
+            return before(k) ? left : right;
+        }
+    };
+
+    /**
+     * Where a search for a key ended: the leaf, its parent and its
+     * grandparent (nullptr if the parent is the root).
+     */
+    struct Position {
+        Node *grandparent, *parent, *leaf;
+    };
+
+    Node *root;
+    std::atomic<int> count;
+
+    static Node *load(const std::atomic<Node *> &link) {
+        return link.load(std::memory_order_acquire);
+    }
+
+    Position search(const KeyType &key) const;
+
+    static bool holds(const Node *leaf, const KeyType &key) {
+        return leaf->infinity == 0 && !(key < leaf->key) && !(leaf->key < key);
+    }
+};
+
+template<typename KeyType>
+FineGrainedBST<KeyType>::FineGrainedBST() : root(new Node(KeyType(), 2, false)), count(0) {
+    root->left.store(new Node(KeyType(), 1, true));
+    root->right.store(new Node(KeyType(), 2, true));
+}
+
+template<typename KeyType>
+FineGrainedBST<KeyType>::~FineGrainedBST() {
+    std::vector<Node *> todo{root};
+    while (!todo.empty()) {
+        Node *n = todo.back();
+        todo.pop_back();
+        if (!n->leaf) {
+            todo.push_back(n->left.load());
+            todo.push_back(n->right.load());
+        }
+        delete n;
+    }
+}
+
+template<typename KeyType>
+typename FineGrainedBST<KeyType>::Position FineGrainedBST<KeyType>::search(const KeyType &key) const {
+    Position at{nullptr, nullptr, root};
+    while (!at.leaf->leaf) {
+        at.grandparent = at.parent;
+        at.parent = at.leaf;
+        at.leaf = load(at.leaf->childFor(key));
+    }
+    return at;
+}
+
+template<typename KeyType>
+bool FineGrainedBST<KeyType>::has(const KeyType &key) const {
+    EpochDomain::Guard guard;
+    return holds(search(key).leaf, key);
+}
+
+template<typename KeyType>
+void FineGrainedBST<KeyType>::add(const KeyType &newKey) {
+    EpochDomain::Guard guard;
+    while (true) {
+        Position at = search(newKey);
+        if (holds(at.leaf, newKey))
+            return; // already an element
+
+        Node *parent = at.parent;
+        std::atomic<Node *> &link = parent->childFor(newKey);
+        parent->lock.lock();
+        if (!parent->removed && link.load(std::memory_order_relaxed) == at.leaf) {
+            // the router takes the larger key, smaller keys go left
+            Node *fresh = new Node(newKey, 0, true);
+            Node *router;
+            if (at.leaf->before(newKey)) {
+                router = new Node(at.leaf->key, at.leaf->infinity, false);
+                router->left.store(fresh, std::memory_order_relaxed);
+                router->right.store(at.leaf, std::memory_order_relaxed);
+            } else {
+                router = new Node(newKey, 0, false);
+                router->left.store(at.leaf, std::memory_order_relaxed);
+                router->right.store(fresh, std::memory_order_relaxed);
+            }
+            link.store(router, std::memory_order_release);
+            parent->lock.unlock();
+            count.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        parent->lock.unlock(); // lost a race, search again
+    }
+}
+
+template<typename KeyType>
+void FineGrainedBST<KeyType>::remove(const KeyType &key) {
+    EpochDomain::Guard guard;
+    while (true) {
+        Position at = search(key);
+        if (!holds(at.leaf, key))
+            return; // not an element
+
+        // real leaves are always below the root's left router, so there
+        // is a grandparent. Locks are taken top-down.
+        Node *grandparent = at.grandparent, *parent = at.parent;
+        std::atomic<Node *> &upper = grandparent->childFor(key);
+        std::atomic<Node *> &lower = parent->childFor(key);
+        grandparent->lock.lock();
+        parent->lock.lock();
+        if (!grandparent->removed && upper.load(std::memory_order_relaxed) == parent
+            && !parent->removed && lower.load(std::memory_order_relaxed) == at.leaf) {
+            Node *sibling = (&lower == &parent->left ? parent->right : parent->left)
+                    .load(std::memory_order_relaxed);
+            parent->removed = true;
+            upper.store(sibling, std::memory_order_release);
+            parent->lock.unlock();
+            grandparent->lock.unlock();
+            EpochDomain &epochs = EpochDomain::global();
+            epochs.retire(parent);
+            epochs.retire(at.leaf);
+            count.fetch_sub(1, std::memory_order_relaxed);
+            return;
+        }
+        parent->lock.unlock();
+        grandparent->lock.unlock(); // lost a race, search again
+    }
+}
+
+template<typename KeyType>
+bool FineGrainedBST<KeyType>::isEmpty() const {
+    return size() == 0;
+}
+
+template<typename KeyType>
+int FineGrainedBST<KeyType>::size() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+template<typename KeyType>
+std::string FineGrainedBST<KeyType>::getInOrderTraversal() const {
+    std::ostringstream ss;
+    forEachInOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType>
+template<typename Visit>
+void FineGrainedBST<KeyType>::forEachInOrder(Visit visit) const {
+    EpochDomain::Guard guard;
+    std::vector<const Node *> todo{root};
+    while (!todo.empty()) {
+        const Node *me = todo.back();
+        todo.pop_back();
+        if (me->leaf) {
+            if (me->infinity == 0)
+                visit(me->key);
+        } else {
+            todo.push_back(load(me->right));
+            todo.push_back(load(me->left));
+        }
+    }
+}
+
+#endif //PROJECT3_FINEGRAINEDBST_H
@@ -0,0 +1,305 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_FROZENBST_H
+#define PROJECT3_FROZENBST_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <vector>
+#include "BST.h"
+#include "Eytzinger.h"
+
+/**
+ * std::allocator replacement that starts every block on a cache line, so
+ * the children of an Eytzinger node share a line as often as possible.
+ */
+template<typename T>
+struct CacheAlignedAllocator {
+    using value_type = T;
+    static constexpr std::size_t ALIGNMENT = 64;
+
+    CacheAlignedAllocator() = default;
+
+    template<typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U> &) {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(ALIGNMENT)));
+    }
+
+    void deallocate(T *p, std::size_t) {
+        ::operator delete(p, std::align_val_t(ALIGNMENT));
+    }
+
+    template<typename U>
+    bool operator==(const CacheAlignedAllocator<U> &) const { return true; }
+
+    template<typename U>
+    bool operator!=(const CacheAlignedAllocator<U> &) const { return false; }
+};
+
+/**
+ * @class FrozenBST - read-only set stored as an implicit tree
+ *
+ * The keys live in one array in Eytzinger (breadth-first) order: the
+ * root is at index 1 and the children of index k are at 2k and 2k + 1.
+ * There are no child pointers, the top levels share a handful of cache
+ * lines, and has() descends without a data-dependent branch while
+ * prefetching the node's great-grandchildren. The set cannot be changed
+ * after construction; build a new one from a BST instead.
+ */
+template<typename KeyType>
+class FrozenBST {
+public:
+    /**
+     * Creates an empty set.
+     */
+    FrozenBST();
+
+    /**
+     * Freeze a snapshot of tree in O(n).
+     * @param tree  the BST to copy the keys from
+     */
+    template<typename Balance, template<typename> class Allocator>
+    explicit FrozenBST(const BST<KeyType, Balance, Allocator> &tree);
+
+    /**
+     * Freeze the keys in [first, last), which must be strictly ascending.
+     * @param first  start of the sorted keys
+     * @param last   end of the sorted keys
+     */
+    template<typename ForwardIt>
+    FrozenBST(ForwardIt first, ForwardIt last);
+
+    /**
+     * Determine if the given key is in this set
+     * @param key  possible element of this set
+     * @return     true if key is an element, false otherwise
+     */
+    bool has(const KeyType &key) const;
+
+    /**
+     * Check if this is an empty set.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Count the number of elements in this set. O(1).
+     */
+    int size() const;
+
+    /**
+     * Count the leaves of the implicit tree. O(1).
+     */
+    int getLeafCount() const;
+
+    /**
+     * Height of the implicit tree, floor(log2(n)) + 1. O(1).
+     */
+    int getHeight() const;
+
+    /**
+     * Returns a string of the elements in ascending order.
+     */
+    std::string getInOrderTraversal() const;
+
+    /**
+     * Returns a string of the elements in pre-order of the implicit tree.
+     */
+    std::string getPreOrderTraversal() const;
+
+    /**
+     * Returns a string of the elements in post-order of the implicit tree.
+     */
+    std::string getPostOrderTraversal() const;
+
+    /**
+     * Calls visit(key) on every element in ascending order.
+     * @param visit  callable taking const KeyType &
+     */
+    template<typename Visit>
+    void forEachInOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in pre-order of the implicit tree.
+     * @param visit  callable taking const KeyType &
+     */
+    template<typename Visit>
+    void forEachPreOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in post-order of the implicit tree.
+     * @param visit  callable taking const KeyType &
+     */
+    template<typename Visit>
+    void forEachPostOrder(Visit visit) const;
+
+private:
+    /**
+     * keys[1..n] in Eytzinger order; keys[0] is unused padding so the
+     * index arithmetic needs no offsets.
+     */
+    std::vector<KeyType, CacheAlignedAllocator<KeyType>> keys;
+
+    /**
+     * Number of elements.
+     */
+    std::size_t n;
+
+    /**
+     * Index of the smallest element, or 0 if the set is empty.
+     */
+    std::size_t firstInOrder() const;
+
+    /**
+     * Index of the in-order successor of index k, or 0 after the largest.
+     */
+    std::size_t nextInOrder(std::size_t k) const;
+};
+
+template<typename KeyType>
+FrozenBST<KeyType>::FrozenBST() : n(0) {
+}
+
+template<typename KeyType>
+template<typename Balance, template<typename> class Allocator>
+FrozenBST<KeyType>::FrozenBST(const BST<KeyType, Balance, Allocator> &tree) : n(0) {
+    n = static_cast<std::size_t>(tree.size());
+    keys.resize(n + 1);
+    std::size_t k = firstInOrder();
+    tree.forEachInOrder([this, &k](const KeyType &key) {
+        keys[k] = key;
+        k = nextInOrder(k);
+    });
+}
+
+template<typename KeyType>
+template<typename ForwardIt>
+FrozenBST<KeyType>::FrozenBST(ForwardIt first, ForwardIt last) : n(0) {
+    n = static_cast<std::size_t>(std::distance(first, last));
+    keys.resize(n + 1);
+    for (std::size_t k = firstInOrder(); k != 0; k = nextInOrder(k), ++first)
+        keys[k] = *first;
+}
+
+template<typename KeyType>
+std::size_t FrozenBST<KeyType>::firstInOrder() const {
+    return eytzingerFirst(n);
+}
+
+template<typename KeyType>
+std::size_t FrozenBST<KeyType>::nextInOrder(std::size_t k) const {
+    return eytzingerNext(k, n);
+}
+
+template<typename KeyType>
+bool FrozenBST<KeyType>::has(const KeyType &key) const {
+    const KeyType *base = keys.data();
+    std::size_t k = 1;
+    while (k <= n) {
+#if defined(__GNUC__)
+        std::size_t ahead = 8 * k < n ? 8 * k : n;
+        __builtin_prefetch(base + ahead);
+#endif
+        k = 2 * k + (base[k] < key);
+    }
+    k = eytzingerLowerBound(k);
+    return k != 0 && !(key < base[k]);
+}
+
+template<typename KeyType>
+bool FrozenBST<KeyType>::isEmpty() const {
+    return n == 0;
+}
+
+template<typename KeyType>
+int FrozenBST<KeyType>::size() const {
+    return static_cast<int>(n);
+}
+
+template<typename KeyType>
+int FrozenBST<KeyType>::getLeafCount() const {
+    return static_cast<int>(n - n / 2);
+}
+
+template<typename KeyType>
+int FrozenBST<KeyType>::getHeight() const {
+    int height = 0;
+    for (std::size_t k = n; k != 0; k >>= 1)
+        ++height;
+    return height;
+}
+
+template<typename KeyType>
+std::string FrozenBST<KeyType>::getInOrderTraversal() const {
+    std::ostringstream ss;
+    forEachInOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType>
+std::string FrozenBST<KeyType>::getPreOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPreOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType>
+std::string FrozenBST<KeyType>::getPostOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPostOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType>
+template<typename Visit>
+void FrozenBST<KeyType>::forEachInOrder(Visit visit) const {
+    for (std::size_t k = firstInOrder(); k != 0; k = nextInOrder(k))
+        visit(keys[k]);
+}
+
+template<typename KeyType>
+template<typename Visit>
+void FrozenBST<KeyType>::forEachPreOrder(Visit visit) const {
+    std::size_t k = n == 0 ? 0 : 1;
+    while (k != 0) {
+        visit(keys[k]);
+        if (2 * k <= n) {
+            k = 2 * k;
+        } else {
+            // climb while I am a right child or have no right sibling
+            while (k > 1 && ((k & 1) || k + 1 > n))
+                k >>= 1;
+            k = k > 1 ? k + 1 : 0;
+        }
+    }
+}
+
+template<typename KeyType>
+template<typename Visit>
+void FrozenBST<KeyType>::forEachPostOrder(Visit visit) const {
+    if (n == 0)
+        return;
+    std::size_t k = 1;
+    while (2 * k <= n)
+        k *= 2;
+    while (true) {
+        visit(keys[k]);
+        if (k == 1)
+            return;
+        if (!(k & 1) && k + 1 <= n) {
+            // left child: next is the deepest left-most node of my sibling
+            k = k + 1;
+            while (2 * k <= n)
+                k *= 2;
+        } else {
+            k >>= 1;
+        }
+    }
+}
+
+#endif //PROJECT3_FROZENBST_H
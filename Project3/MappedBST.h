@@ -0,0 +1,503 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_MAPPEDBST_H
+#define PROJECT3_MAPPEDBST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "BST.h"
+#include "Eytzinger.h"
+
+/**
+ * @file MappedBST.h - binary set files and a read-only set that queries
+ * them in place through mmap
+ *
+ * File format, version 1, in native byte order. Every section starts on
+ * a 64-byte boundary:
+ *
+ *     header   MappedHeader
+ *     sorted   fixed-size keys: the n keys, ascending
+ *              strings: n + 1 uint64 offsets into data, key i being
+ *              the bytes [offset[i], offset[i + 1])
+ *     layout   optional (MAPPED_HAS_LAYOUT): the implicit tree in
+ *              Eytzinger order, slots 0..n with slot 0 unused; the keys
+ *              themselves for fixed-size keys, (offset, length) uint64
+ *              pairs into data for strings
+ *     data     strings only: the key bytes back to back, ascending
+ *
+ * Fixed-size keys must be trivially copyable; the file is only readable
+ * by builds with the same key size and byte order.
+ */
+
+const uint32_t MAPPED_VERSION = 1;
+const uint32_t MAPPED_BYTE_ORDER = 0x01020304;
+const uint32_t MAPPED_FIXED_KEYS = 1;
+const uint32_t MAPPED_STRING_KEYS = 2;
+const uint32_t MAPPED_HAS_LAYOUT = 1;
+
+struct MappedHeader {
+    char magic[8];          // "BSTSET\0\0"
+    uint32_t version;
+    uint32_t byteOrder;     // MAPPED_BYTE_ORDER as written
+    uint32_t keyKind;       // MAPPED_FIXED_KEYS or MAPPED_STRING_KEYS
+    uint32_t keySize;       // bytes per fixed-size key, 0 for strings
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t count;
+    uint64_t sortedOffset, layoutOffset, dataOffset;
+    uint64_t fileSize;
+};
+
+/**
+ * Whether keys are stored as fixed-size records or through an offset
+ * table; specialized for std::string.
+ */
+template<typename KeyType>
+struct MappedKeyKind {
+    static_assert(std::is_trivially_copyable<KeyType>::value,
+                  "mapped keys must be trivially copyable or std::string");
+    static const uint32_t kind = MAPPED_FIXED_KEYS;
+};
+
+template<>
+struct MappedKeyKind<std::string> {
+    static const uint32_t kind = MAPPED_STRING_KEYS;
+};
+
+/**
+ * Write the keys *sorted[0] < *sorted[1] < ... to path in the format
+ * above.
+ * @param path            file to create or replace
+ * @param sorted          the keys in ascending order
+ * @param implicitLayout  also write the Eytzinger layout section
+ * @throws std::runtime_error if the file cannot be written
+ */
+template<typename KeyType>
+void saveMapped(const std::string &path, const std::vector<const KeyType *> &sorted, bool implicitLayout) {
+    constexpr bool strings = MappedKeyKind<KeyType>::kind == MAPPED_STRING_KEYS;
+    const uint64_t ALIGN = 64;
+    auto align = [ALIGN](uint64_t offset) { return (offset + ALIGN - 1) / ALIGN * ALIGN; };
+    uint64_t n = sorted.size();
+    // strings are stored as offsets, and as (offset, length) in the layout
+    uint64_t record = strings ? sizeof(uint64_t) : sizeof(KeyType);
+    uint64_t layoutRecord = strings ? 2 * sizeof(uint64_t) : sizeof(KeyType);
+
+    MappedHeader header{};
+    std::memcpy(header.magic, "BSTSET\0\0", 8);
+    header.version = MAPPED_VERSION;
+    header.byteOrder = MAPPED_BYTE_ORDER;
+    header.keyKind = MappedKeyKind<KeyType>::kind;
+    header.keySize = strings ? 0 : sizeof(KeyType);
+    header.flags = implicitLayout ? MAPPED_HAS_LAYOUT : 0;
+    header.count = n;
+    header.sortedOffset = align(sizeof(MappedHeader));
+    uint64_t end = header.sortedOffset + (strings ? n + 1 : n) * record;
+    if (implicitLayout) {
+        header.layoutOffset = align(end);
+        end = header.layoutOffset + (n + 1) * layoutRecord;
+    }
+    if constexpr (strings) {
+        header.dataOffset = align(end);
+        end = header.dataOffset;
+        for (const KeyType *key : sorted)
+            end += key->size();
+    }
+    header.fileSize = end;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+        throw std::runtime_error("cannot create " + path);
+    auto put = [&out](const void *p, size_t bytes) {
+        out.write(static_cast<const char *>(p), static_cast<std::streamsize>(bytes));
+    };
+    auto padTo = [&out, &put](uint64_t offset) {
+        static const char zeros[64] = {};
+        put(zeros, offset - static_cast<uint64_t>(out.tellp()));
+    };
+
+    put(&header, sizeof header);
+    padTo(header.sortedOffset);
+    std::vector<uint64_t> offsets;
+    if constexpr (strings) {
+        offsets.reserve(n + 1);
+        offsets.push_back(0);
+        for (const KeyType *key : sorted)
+            offsets.push_back(offsets.back() + key->size());
+        put(offsets.data(), offsets.size() * sizeof(uint64_t));
+    } else {
+        for (const KeyType *key : sorted)
+            put(key, sizeof(KeyType));
+    }
+    if (implicitLayout) {
+        padTo(header.layoutOffset);
+        std::vector<uint64_t> rankAt(n + 1, 0);
+        uint64_t rank = 0;
+        for (size_t k = eytzingerFirst(n); k != 0; k = eytzingerNext(k, n))
+            rankAt[k] = rank++;
+        if constexpr (strings) {
+            uint64_t unused[2] = {0, 0};
+            put(unused, sizeof unused);
+            for (uint64_t k = 1; k <= n; k++) {
+                uint64_t place[2] = {offsets[rankAt[k]], offsets[rankAt[k] + 1] - offsets[rankAt[k]]};
+                put(place, sizeof place);
+            }
+        } else {
+            static const char unused[sizeof(KeyType)] = {};
+            put(unused, sizeof unused);
+            for (uint64_t k = 1; k <= n; k++)
+                put(sorted[rankAt[k]], sizeof(KeyType));
+        }
+    }
+    if constexpr (strings) {
+        padTo(header.dataOffset);
+        for (const KeyType *key : sorted)
+            put(key->data(), key->size());
+    }
+    out.flush();
+    if (!out)
+        throw std::runtime_error("cannot write " + path);
+}
+
+/**
+ * Write a BST to path in the format above: the sorted keys, an offset
+ * table for strings, and optionally the keys again in implicit tree order.
+ * @param set             the set to write
+ * @param path            file to create or replace
+ * @param implicitLayout  also store the Eytzinger layout, so that lookups
+ *                        on the mapped file touch fewer pages
+ * @throws std::runtime_error if the file cannot be written
+ */
+template<typename KeyType, typename Balance, template<typename> class Allocator>
+void saveMapped(const BST<KeyType, Balance, Allocator> &set, const std::string &path, bool implicitLayout = true) {
+    std::vector<const KeyType *> sorted;
+    sorted.reserve(set.size());
+    set.forEachInOrder([&sorted](const KeyType &key) { sorted.push_back(&key); });
+    saveMapped(path, sorted, implicitLayout);
+}
+
+/**
+ * @class MappedBST - read-only set over a file written by saveMapped()
+ *
+ * Opening maps the file and checks that its header and sections agree with
+ * the file's size; nothing is copied and the pages are shared with every
+ * other process mapping the same file. Fixed-size keys open in O(1); for
+ * strings the offset tables are checked too, in O(n) without reading the
+ * key bytes. has() walks
+ * the implicit tree when the file has one and binary searches the sorted
+ * keys otherwise.
+ *
+ * String sets hand their keys out as std::string_view into the mapping.
+ * Movable, not copyable.
+ */
+template<typename KeyType>
+class MappedBST {
+public:
+    /**
+     * The type traversals hand to the visitor.
+     */
+    using KeyView = typename std::conditional<MappedKeyKind<KeyType>::kind == MAPPED_STRING_KEYS,
+            std::string_view, KeyType>::type;
+
+    /**
+     * Map the set file at path.
+     * @throws std::runtime_error if it cannot be opened, was not written
+     *         by saveMapped() for this KeyType on this platform, or is
+     *         truncated or corrupt
+     */
+    explicit MappedBST(const std::string &path);
+
+    ~MappedBST();
+
+    MappedBST(const MappedBST &) = delete;
+
+    MappedBST &operator=(const MappedBST &) = delete;
+
+    MappedBST(MappedBST &&other) noexcept;
+
+    MappedBST &operator=(MappedBST &&rhs) noexcept;
+
+    /**
+     * Determine if the given key is in this set.
+     * @param key  possible element of this set
+     * @return     true if key is an element, false otherwise
+     */
+    bool has(const KeyType &key) const;
+
+    /**
+     * Check if this is an empty set.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Count the number of elements in this set. O(1).
+     */
+    int size() const;
+
+    /**
+     * Whether the file carries the implicit tree layout.
+     */
+    bool hasLayout() const;
+
+    /**
+     * Returns a string of the elements in ascending order.
+     */
+    std::string getInOrderTraversal() const;
+
+    /**
+     * Calls visit(key) on every element in ascending order.
+     * @param visit  callable taking KeyView
+     */
+    template<typename Visit>
+    void forEachInOrder(Visit visit) const;
+
+private:
+    static const bool STRINGS = MappedKeyKind<KeyType>::kind == MAPPED_STRING_KEYS;
+
+    const char *base;
+    size_t length;
+    size_t n;
+    const char *sorted;    // keys or string offsets
+    const char *layout;    // nullptr without the layout section
+    const char *data;
+
+    /**
+     * Whether the string offsets and the layout's (offset, length) pairs
+     * stay inside the dataLength bytes of the data section.
+     */
+    bool stringsInBounds(uint64_t dataLength) const;
+
+    /**
+     * The element of rank i.
+     */
+    KeyView keyAt(size_t i) const;
+
+    /**
+     * The element in Eytzinger slot k.
+     */
+    KeyView slot(size_t k) const;
+
+    void unmap();
+};
+
+template<typename KeyType>
+MappedBST<KeyType>::MappedBST(const std::string &path)
+        : base(nullptr), length(0), n(0), sorted(nullptr), layout(nullptr), data(nullptr) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw std::runtime_error("cannot open " + path);
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(MappedHeader)) {
+        ::close(fd);
+        throw std::runtime_error(path + " is not a set file");
+    }
+    length = static_cast<size_t>(info.st_size);
+    void *p = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED)
+        throw std::runtime_error("cannot map " + path);
+    base = static_cast<const char *>(p);
+
+    MappedHeader header;
+    std::memcpy(&header, base, sizeof header);
+    const char *problem = nullptr;
+    if (std::memcmp(header.magic, "BSTSET\0\0", 8) != 0)
+        problem = "is not a set file";
+    else if (header.version != MAPPED_VERSION)
+        problem = "has an unsupported version";
+    else if (header.byteOrder != MAPPED_BYTE_ORDER)
+        problem = "was written with another byte order";
+    else if (header.keyKind != MappedKeyKind<KeyType>::kind
+             || header.keySize != (STRINGS ? 0 : sizeof(KeyType)))
+        problem = "holds another key type";
+    else if (header.fileSize != length)
+        problem = "is truncated";
+    else if (header.count >= length)
+        problem = "has a corrupt key count";
+    if (problem == nullptr) {
+        // every section must start aligned, after the one before it, and
+        // end inside the file; fits() cannot overflow on any header
+        const uint64_t ALIGN = 64;
+        auto fits = [this, ALIGN](uint64_t offset, uint64_t count, uint64_t record) {
+            return offset % ALIGN == 0 && offset <= length && count <= (length - offset) / record;
+        };
+        uint64_t record = STRINGS ? sizeof(uint64_t) : sizeof(KeyType);
+        uint64_t layoutRecord = STRINGS ? 2 * sizeof(uint64_t) : sizeof(KeyType);
+        uint64_t sortedCount = STRINGS ? header.count + 1 : header.count;
+        uint64_t end = header.sortedOffset + sortedCount * record;
+        if (header.sortedOffset < sizeof(MappedHeader) || !fits(header.sortedOffset, sortedCount, record))
+            problem = "has a corrupt key section";
+        else if (header.flags & MAPPED_HAS_LAYOUT) {
+            if (header.layoutOffset < end || !fits(header.layoutOffset, header.count + 1, layoutRecord))
+                problem = "has a corrupt layout section";
+            end = header.layoutOffset + (header.count + 1) * layoutRecord;
+        }
+        if (problem == nullptr && STRINGS && (header.dataOffset < end || header.dataOffset > length))
+            problem = "has a corrupt data section";
+    }
+    if (problem == nullptr) {
+        n = header.count;
+        sorted = base + header.sortedOffset;
+        layout = (header.flags & MAPPED_HAS_LAYOUT) ? base + header.layoutOffset : nullptr;
+        data = STRINGS ? base + header.dataOffset : nullptr;
+        if (STRINGS && !stringsInBounds(length - header.dataOffset))
+            problem = "has corrupt string offsets";
+    }
+    if (problem != nullptr) {
+        unmap();
+        throw std::runtime_error(path + " " + problem);
+    }
+}
+
+template<typename KeyType>
+MappedBST<KeyType>::~MappedBST() {
+    unmap();
+}
+
+template<typename KeyType>
+MappedBST<KeyType>::MappedBST(MappedBST &&other) noexcept
+        : base(other.base), length(other.length), n(other.n), sorted(other.sorted),
+          layout(other.layout), data(other.data) {
+    other.base = nullptr;
+    other.length = other.n = 0;
+}
+
+template<typename KeyType>
+MappedBST<KeyType> &MappedBST<KeyType>::operator=(MappedBST &&rhs) noexcept {
+    if (this != &rhs) {
+        unmap();
+        base = rhs.base;
+        length = rhs.length;
+        n = rhs.n;
+        sorted = rhs.sorted;
+        layout = rhs.layout;
+        data = rhs.data;
+        rhs.base = nullptr;
+        rhs.length = rhs.n = 0;
+    }
+    return *this;
+}
+
+template<typename KeyType>
+void MappedBST<KeyType>::unmap() {
+    if (base != nullptr)
+        ::munmap(const_cast<char *>(base), length);
+    base = nullptr;
+}
+
+template<typename KeyType>
+bool MappedBST<KeyType>::stringsInBounds(uint64_t dataLength) const {
+    const uint64_t *offsets = reinterpret_cast<const uint64_t *>(sorted);
+    if (offsets[0] != 0 || offsets[n] > dataLength)
+        return false;
+    for (size_t i = 0; i < n; i++)
+        if (offsets[i + 1] < offsets[i])
+            return false;
+    if (layout != nullptr) {
+        const uint64_t *place = reinterpret_cast<const uint64_t *>(layout);
+        for (size_t k = 1; k <= n; k++)
+            if (place[2 * k] > dataLength || place[2 * k + 1] > dataLength - place[2 * k])
+                return false;
+    }
+    return true;
+}
+
+template<typename KeyType>
+typename MappedBST<KeyType>::KeyView MappedBST<KeyType>::keyAt(size_t i) const {
+    if constexpr (STRINGS) {
+        const uint64_t *offsets = reinterpret_cast<const uint64_t *>(sorted);
+        return std::string_view(data + offsets[i], offsets[i + 1] - offsets[i]);
+    } else {
+        return reinterpret_cast<const KeyType *>(sorted)[i];
+    }
+}
+
+template<typename KeyType>
+typename MappedBST<KeyType>::KeyView MappedBST<KeyType>::slot(size_t k) const {
+    if constexpr (STRINGS) {
+        const uint64_t *place = reinterpret_cast<const uint64_t *>(layout) + 2 * k;
+        return std::string_view(data + place[0], place[1]);
+    } else
+        return reinterpret_cast<const KeyType *>(layout)[k];
+}
+
+template<typename KeyType>
+bool MappedBST<KeyType>::has(const KeyType &key) const {
+    const KeyView probe(key);
+    if (layout != nullptr) {
+        size_t k = 1;
+        while (k <= n) {
+#if defined(__GNUC__)
+            size_t ahead = 8 * k < n ? 8 * k : n;
+            __builtin_prefetch(layout + ahead * (STRINGS ? 2 * sizeof(uint64_t) : sizeof(KeyType)));
+#endif
+            k = 2 * k + (slot(k) < probe);
+        }
+        k = eytzingerLowerBound(k);
+        return k != 0 && !(probe < slot(k));
+    }
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (keyAt(mid) < probe)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < n && !(probe < keyAt(lo));
+}
+
+template<typename KeyType>
+bool MappedBST<KeyType>::isEmpty() const {
+    return n == 0;
+}
+
+template<typename KeyType>
+int MappedBST<KeyType>::size() const {
+    return static_cast<int>(n);
+}
+
+template<typename KeyType>
+bool MappedBST<KeyType>::hasLayout() const {
+    return layout != nullptr;
+}
+
+template<typename KeyType>
+std::string MappedBST<KeyType>::getInOrderTraversal() const {
+    std::ostringstream ss;
+    forEachInOrder([&ss](const KeyView &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType>
+template<typename Visit>
+void MappedBST<KeyType>::forEachInOrder(Visit visit) const {
+    for (size_t i = 0; i < n; i++)
+        visit(keyAt(i));
+}
+
+/**
+ * Open a file written by saveMapped() as a read-only set queried straight
+ * from the page cache, without building any nodes.
+ * @param path  file written by saveMapped() for this KeyType
+ * @throws std::runtime_error if it is not such a file
+ */
+template<typename KeyType>
+MappedBST<KeyType> openMapped(const std::string &path) {
+    return MappedBST<KeyType>(path);
+}
+
+#endif //PROJECT3_MAPPEDBST_H
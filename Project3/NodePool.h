@@ -0,0 +1,184 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_NODEPOOL_H
+#define PROJECT3_NODEPOOL_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @file NodePool.h - node allocation policies for BST<KeyType, Balance, Allocator>
+ *
+ * An allocator policy is a class template over the node type providing
+ *
+ *     template<typename... Args> T *create(Args &&... args);
+ *     void destroy(T *p);
+ *     void releaseAll();
+ *     void adopt(Policy &&other);
+ *     static constexpr bool bulkRelease;
+ *
+ * releaseAll() is only called when bulkRelease is true and T is trivially
+ * destructible; it must give back every node created so far without
+ * visiting them. adopt() makes this allocator responsible for the nodes
+ * created by other, so subtrees can be built with separate allocators on
+ * separate threads and then joined. Policies are movable but not
+ * copyable: a copied tree gets its own allocator.
+ */
+
+/**
+ * Plain new/delete, one heap allocation per node.
+ */
+template<typename T>
+class NewDeleteAllocator {
+public:
+    static constexpr bool bulkRelease = false;
+
+    template<typename... Args>
+    T *create(Args &&... args) {
+        return new T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T *p) {
+        delete p;
+    }
+
+    void releaseAll() {}
+
+    void adopt(NewDeleteAllocator &&) {}
+};
+
+/**
+ * Slab allocator: nodes are carved out of contiguous chunks that grow
+ * geometrically, freed nodes are recycled through an intrusive free list,
+ * and releaseAll() drops the whole tree in O(chunks).
+ */
+template<typename T>
+class NodePool {
+public:
+    static constexpr bool bulkRelease = true;
+
+    NodePool() = default;
+
+    ~NodePool() {
+        releaseAll();
+    }
+
+    NodePool(const NodePool &) = delete;
+
+    NodePool &operator=(const NodePool &) = delete;
+
+    NodePool(NodePool &&other) noexcept {
+        swap(other);
+    }
+
+    NodePool &operator=(NodePool &&rhs) noexcept {
+        if (this != &rhs) {
+            releaseAll();
+            swap(rhs);
+        }
+        return *this;
+    }
+
+    /**
+     * Construct a T in a recycled slot, or the next free slot of the
+     * current chunk (starting a new chunk if it is full).
+     */
+    template<typename... Args>
+    T *create(Args &&... args) {
+        Slot *slot = grab();
+        try {
+            return new(slot->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            slot->next = freeList;
+            freeList = slot;
+            throw;
+        }
+    }
+
+    /**
+     * Destroy p and push its slot on the free list.
+     */
+    void destroy(T *p) {
+        p->~T();
+        Slot *slot = reinterpret_cast<Slot *>(p);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+    /**
+     * Return every chunk to the heap without running destructors.
+     */
+    void releaseAll() {
+        for (Slot *chunk : chunks)
+            ::operator delete(chunk);
+        chunks.clear();
+        freeList = nullptr;
+        next = end = nullptr;
+        chunkSize = MIN_CHUNK;
+    }
+
+    /**
+     * Take over every chunk and free slot of other, leaving it empty. The
+     * unused rest of other's current chunk is only returned by
+     * releaseAll().
+     */
+    void adopt(NodePool &&other) {
+        chunks.insert(chunks.end(), other.chunks.begin(), other.chunks.end());
+        other.chunks.clear();
+        if (other.freeList != nullptr) {
+            Slot *tail = other.freeList;
+            while (tail->next != nullptr)
+                tail = tail->next;
+            tail->next = freeList;
+            freeList = other.freeList;
+        }
+        other.freeList = nullptr;
+        other.next = other.end = nullptr;
+        other.chunkSize = MIN_CHUNK;
+    }
+
+    void swap(NodePool &other) noexcept {
+        chunks.swap(other.chunks);
+        std::swap(freeList, other.freeList);
+        std::swap(next, other.next);
+        std::swap(end, other.end);
+        std::swap(chunkSize, other.chunkSize);
+    }
+
+private:
+    union Slot {
+        Slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    static constexpr std::size_t MIN_CHUNK = 64;
+    static constexpr std::size_t MAX_CHUNK = 64 * 1024;
+
+    std::vector<Slot *> chunks;
+    Slot *freeList = nullptr;
+    Slot *next = nullptr, *end = nullptr;
+    std::size_t chunkSize = MIN_CHUNK;
+
+    Slot *grab() {
+        if (freeList != nullptr) {
+            Slot *slot = freeList;
+            freeList = slot->next;
+            return slot;
+        }
+        if (next == end) {
+            chunks.reserve(chunks.size() + 1);
+            next = static_cast<Slot *>(::operator new(chunkSize * sizeof(Slot)));
+            end = next + chunkSize;
+            chunks.push_back(next);
+            if (chunkSize < MAX_CHUNK)
+                chunkSize *= 2;
+        }
+        return next++;
+    }
+};
+
+#endif //PROJECT3_NODEPOOL_H
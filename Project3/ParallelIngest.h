@@ -0,0 +1,78 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_PARALLELINGEST_H
+#define PROJECT3_PARALLELINGEST_H
+
+#include <algorithm>
+#include <future>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "FastParse.h"
+
+/**
+ * Read the integers in the file at path as parseInts() does, stopping at
+ * the first token that is not a number, parsing threads slices of the
+ * file at once. The file is mapped and cut at separators, so no number
+ * straddles two slices; the numbers come out in file order, and none from
+ * slices after the one that stopped.
+ * @param path     file to read
+ * @param keys     receives the numbers (appended)
+ * @param threads  how many threads may parse at once
+ * @return         false if the file could not be opened
+ */
+inline bool readIntFile(const char *path, std::vector<int> &keys, unsigned threads) {
+    MappedFile file(path);
+    if (!file.isOpen())
+        return false;
+    std::string_view text = file.text();
+    size_t size = text.size();
+
+    if (threads <= 1) {
+        parseInts(text, keys);
+        return true;
+    }
+    std::vector<size_t> cuts(threads + 1, size);
+    cuts[0] = 0;
+    for (unsigned i = 1; i < threads; i++) {
+        size_t cut = std::max(cuts[i - 1], size / threads * i);
+        while (cut < size && static_cast<unsigned char>(text[cut]) > ' ')
+            ++cut;
+        cuts[i] = cut;
+    }
+
+    // each slice's numbers, and whether it reached its end
+    using Slice = std::pair<std::vector<int>, bool>;
+    auto parse = [text](size_t from, size_t to) {
+        Slice out;
+        out.first.reserve((to - from) / 8);
+        out.second = parseInts(text.substr(from, to - from), out.first);
+        return out;
+    };
+    std::vector<std::future<Slice>> slices;
+    for (unsigned i = 1; i < threads; i++)
+        slices.push_back(std::async(std::launch::async, parse, cuts[i], cuts[i + 1]));
+    Slice part = parse(cuts[0], cuts[1]);
+    keys.insert(keys.end(), part.first.begin(), part.first.end());
+    bool complete = part.second;
+    for (std::future<Slice> &slice : slices) {
+        part = slice.get();
+        if (complete)
+            keys.insert(keys.end(), part.first.begin(), part.first.end());
+        complete = complete && part.second;
+    }
+    return true;
+}
+
+/**
+ * readIntFile() using every hardware thread.
+ */
+inline bool readIntFile(const char *path, std::vector<int> &keys) {
+    unsigned threads = std::thread::hardware_concurrency();
+    return readIntFile(path, keys, threads == 0 ? 1 : threads);
+}
+
+#endif //PROJECT3_PARALLELINGEST_H
@@ -0,0 +1,52 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_PARALLELSORT_H
+#define PROJECT3_PARALLELSORT_H
+
+#include <algorithm>
+#include <future>
+#include <iterator>
+#include <thread>
+
+/**
+ * Below this many elements a range is sorted on the calling thread.
+ */
+const long PARALLEL_SORT_CUTOFF = 1L << 15;
+
+/**
+ * Sort [first, last) ascending by operator<, splitting the range in half
+ * and sorting the halves on separate threads (up to threads at once)
+ * before merging them.
+ * @param first    start of a random-access range
+ * @param last     end of the range
+ * @param threads  how many threads may work on the range
+ */
+template<typename RandomIt>
+void parallelSort(RandomIt first, RandomIt last, unsigned threads) {
+    long n = std::distance(first, last);
+    if (threads <= 1 || n < PARALLEL_SORT_CUTOFF) {
+        std::sort(first, last);
+        return;
+    }
+    RandomIt mid = first + n / 2;
+    unsigned leftThreads = threads / 2;
+    auto left = std::async(std::launch::async, [first, mid, leftThreads] {
+        parallelSort(first, mid, leftThreads);
+    });
+    parallelSort(mid, last, threads - leftThreads);
+    left.get();
+    std::inplace_merge(first, mid, last);
+}
+
+/**
+ * Sort [first, last) ascending using every hardware thread.
+ */
+template<typename RandomIt>
+void parallelSort(RandomIt first, RandomIt last) {
+    unsigned threads = std::thread::hardware_concurrency();
+    parallelSort(first, last, threads == 0 ? 1 : threads);
+}
+
+#endif //PROJECT3_PARALLELSORT_H
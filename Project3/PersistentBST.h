@@ -0,0 +1,491 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_PERSISTENTBST_H
+#define PROJECT3_PERSISTENTBST_H
+
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @class PersistentBST - Set ADT whose copies share structure
+ *
+ * Nodes are immutable once built and reference counted, so copying a set
+ * (or taking a snapshot()) just shares the root: O(1), no allocation.
+ * add() and remove() never touch an existing node; they build new copies
+ * of the O(log n) nodes on the path they change, rebalanced AVL style,
+ * and share every other subtree with the previous version.
+ *
+ * Any number of threads may read one PersistentBST at once, and copies
+ * may be used and modified on different threads independently; readers
+ * of an old version take no lock and never wait for writers. As with
+ * BST, a single object must not be modified while another thread uses
+ * that same object.
+ */
+template<typename KeyType>
+class PersistentBST {
+public:
+    /**
+     * Simple constructor creates an empty set.
+     */
+    PersistentBST();
+
+    /**
+     * Destructor. Frees the nodes no other version still shares.
+     */
+    ~PersistentBST();
+
+    /**
+     * Copy constructor shares other's nodes. O(1).
+     * @param other another PersistentBST to copy
+     */
+    PersistentBST(const PersistentBST &other);
+
+    /**
+     * Assignment operator. Drops the current version and shares rhs's. O(1)
+     * plus freeing whatever only the old version held.
+     * @param rhs  another PersistentBST to copy
+     * @return *this
+     */
+    PersistentBST &operator=(const PersistentBST &rhs);
+
+    PersistentBST(PersistentBST &&other) noexcept;
+
+    PersistentBST &operator=(PersistentBST &&rhs) noexcept;
+
+    /**
+     * The current version, unaffected by later changes to this set. O(1).
+     */
+    PersistentBST snapshot() const;
+
+    /**
+     * Determine if the given key is in this set.
+     * @param key  possible element of this set
+     * @return     true if key is an element, false otherwise
+     */
+    bool has(const KeyType &key) const;
+
+    /**
+     * Insert a new element into the set, copying the path to it.
+     * If the element was already in the set, this method does nothing.
+     * @param newKey to insert
+     * @post has(newKey) is true
+     */
+    void add(const KeyType &newKey);
+
+    /**
+     * Remove the given key from this set, copying the path to it.
+     * @param key  an element (possibly) of this set
+     * @post       has(key) is false
+     */
+    void remove(const KeyType &key);
+
+    /**
+     * Check if this is an empty set.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Count the number of elements in this set. O(1).
+     */
+    int size() const;
+
+    /**
+     * Count the leaves of the tree. O(n).
+     */
+    int getLeafCount() const;
+
+    /**
+     * Returns the height of the tree. O(1).
+     */
+    int getHeight() const;
+
+    std::string getInOrderTraversal() const;
+
+    std::string getPreOrderTraversal() const;
+
+    std::string getPostOrderTraversal() const;
+
+    /**
+     * Calls visit(key) on every element in ascending order.
+     * @param visit  callable taking const KeyType &
+     */
+    template<typename Visit>
+    void forEachInOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in pre-order order.
+     */
+    template<typename Visit>
+    void forEachPreOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in post-order order.
+     */
+    template<typename Visit>
+    void forEachPostOrder(Visit visit) const;
+
+private:
+    struct Node {
+        const KeyType key;
+        Node *const left, *const right;
+        const int height, count;
+        std::atomic<int> refs;
+
+        /**
+         * Takes over one reference each to lch and rch.
+         */
+        Node(const KeyType &newKey, Node *lch, Node *rch)
+                : key(newKey), left(lch), right(rch),
+                  height(1 + std::max(heightOf(lch), heightOf(rch))),
+                  count(1 + countOf(lch) + countOf(rch)), refs(1) {}
+
+        static int heightOf(const Node *n) {
+            return n == nullptr ? 0 : n->height;
+        }
+
+        static int countOf(const Node *n) {
+            return n == nullptr ? 0 : n->count;
+        }
+    };
+
+    Node *root;
+
+    /**
+     * Add a reference to n (if any) and return it.
+     */
+    static Node *retain(Node *n);
+
+    /**
+     * Drop a reference to n, freeing it and, in turn, every descendant
+     * nobody else holds. Iterative.
+     */
+    static void release(Node *n);
+
+    /**
+     * A node for key over l and r (whose references it takes over),
+     * rotated as needed so that it is AVL balanced when l and r are and
+     * their heights differ by at most 2.
+     */
+    static Node *balance(const KeyType &key, Node *l, Node *r);
+
+    /**
+     * Helper method for add.
+     * @return  the new version of me, or nullptr if newKey is already in it
+     */
+    static Node *add(Node *me, const KeyType &newKey);
+
+    /**
+     * Helper method for remove.
+     * @param found  set to whether key was in me
+     * @return       the new version of me if found
+     */
+    static Node *remove(Node *me, const KeyType &key, bool &found);
+
+    /**
+     * Helper method for remove: me without its smallest key.
+     * @param min  set to the smallest key, which stays owned by me
+     */
+    static Node *removeMin(Node *me, const KeyType *&min);
+};
+
+template<typename KeyType>
+PersistentBST<KeyType>::PersistentBST() : root(nullptr) {
+}
+
+template<typename KeyType>
+PersistentBST<KeyType>::~PersistentBST() {
+    release(root);
+}
+
+template<typename KeyType>
+PersistentBST<KeyType>::PersistentBST(const PersistentBST &other) : root(retain(other.root)) {
+}
+
+template<typename KeyType>
+PersistentBST<KeyType> &PersistentBST<KeyType>::operator=(const PersistentBST &rhs) {
+    Node *old = root;
+    root = retain(rhs.root);
+    release(old);
+    return *this;
+}
+
+template<typename KeyType>
+PersistentBST<KeyType>::PersistentBST(PersistentBST &&other) noexcept : root(other.root) {
+    other.root = nullptr;
+}
+
+template<typename KeyType>
+PersistentBST<KeyType> &PersistentBST<KeyType>::operator=(PersistentBST &&rhs) noexcept {
+    if (this != &rhs) {
+        release(root);
+        root = rhs.root;
+        rhs.root = nullptr;
+    }
+    return *this;
+}
+
+template<typename KeyType>
+PersistentBST<KeyType> PersistentBST<KeyType>::snapshot() const {
+    return *this;
+}
+
+template<typename KeyType>
+bool PersistentBST<KeyType>::has(const KeyType &key) const {
+    const Node *me = root;
+    while (me != nullptr) {
+        if (key < me->key)
+            me = me->left;
+        else if (me->key < key)
+            me = me->right;
+        else
+            return true;
+    }
+    return false;
+}
+
+template<typename KeyType>
+void PersistentBST<KeyType>::add(const KeyType &newKey) {
+    if (Node *fresh = add(root, newKey)) {
+        release(root);
+        root = fresh;
+    }
+}
+
+template<typename KeyType>
+void PersistentBST<KeyType>::remove(const KeyType &key) {
+    bool found = false;
+    Node *fresh = remove(root, key, found);
+    if (found) {
+        release(root);
+        root = fresh;
+    }
+}
+
+template<typename KeyType>
+bool PersistentBST<KeyType>::isEmpty() const {
+    return root == nullptr;
+}
+
+template<typename KeyType>
+int PersistentBST<KeyType>::size() const {
+    return Node::countOf(root);
+}
+
+template<typename KeyType>
+int PersistentBST<KeyType>::getHeight() const {
+    return Node::heightOf(root);
+}
+
+template<typename KeyType>
+int PersistentBST<KeyType>::getLeafCount() const {
+    int leaves = 0;
+    std::vector<const Node *> todo;
+    if (root != nullptr)
+        todo.push_back(root);
+    while (!todo.empty()) {
+        const Node *n = todo.back();
+        todo.pop_back();
+        if (n->left == nullptr && n->right == nullptr)
+            ++leaves;
+        if (n->left != nullptr)
+            todo.push_back(n->left);
+        if (n->right != nullptr)
+            todo.push_back(n->right);
+    }
+    return leaves;
+}
+
+template<typename KeyType>
+typename PersistentBST<KeyType>::Node *PersistentBST<KeyType>::retain(Node *n) {
+    if (n != nullptr)
+        n->refs.fetch_add(1, std::memory_order_relaxed);
+    return n;
+}
+
+template<typename KeyType>
+void PersistentBST<KeyType>::release(Node *n) {
+    std::vector<Node *> todo;
+    if (n != nullptr)
+        todo.push_back(n);
+    while (!todo.empty()) {
+        n = todo.back();
+        todo.pop_back();
+        if (n->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            continue; // still shared
+        if (n->left != nullptr)
+            todo.push_back(n->left);
+        if (n->right != nullptr)
+            todo.push_back(n->right);
+        delete n;
+    }
+}
+
+template<typename KeyType>
+typename PersistentBST<KeyType>::Node *PersistentBST<KeyType>::balance(const KeyType &key, Node *l, Node *r) {
+    int hl = Node::heightOf(l), hr = Node::heightOf(r);
+    if (hl > hr + 1) {
+        Node *result;
+        if (Node::heightOf(l->left) >= Node::heightOf(l->right)) {
+            // single rotation right
+            result = new Node(l->key, retain(l->left), new Node(key, retain(l->right), r));
+        } else {
+            // double rotation: l's right child comes up
+            Node *lr = l->right;
+            result = new Node(lr->key, new Node(l->key, retain(l->left), retain(lr->left)),
+                              new Node(key, retain(lr->right), r));
+        }
+        release(l);
+        return result;
+    }
+    if (hr > hl + 1) {
+        Node *result;
+        if (Node::heightOf(r->right) >= Node::heightOf(r->left)) {
+            result = new Node(r->key, new Node(key, l, retain(r->left)), retain(r->right));
+        } else {
+            Node *rl = r->left;
+            result = new Node(rl->key, new Node(key, l, retain(rl->left)),
+                              new Node(r->key, retain(rl->right), retain(r->right)));
+        }
+        release(r);
+        return result;
+    }
+    return new Node(key, l, r);
+}
+
+template<typename KeyType>
+typename PersistentBST<KeyType>::Node *PersistentBST<KeyType>::add(Node *me, const KeyType &newKey) {
+    if (me == nullptr)
+        return new Node(newKey, nullptr, nullptr);
+    if (newKey < me->key) {
+        Node *l = add(me->left, newKey);
+        return l == nullptr ? nullptr : balance(me->key, l, retain(me->right));
+    }
+    if (me->key < newKey) {
+        Node *r = add(me->right, newKey);
+        return r == nullptr ? nullptr : balance(me->key, retain(me->left), r);
+    }
+    return nullptr; // already an element
+}
+
+template<typename KeyType>
+typename PersistentBST<KeyType>::Node *PersistentBST<KeyType>::remove(Node *me, const KeyType &key, bool &found) {
+    if (me == nullptr) {
+        found = false;
+        return nullptr;
+    }
+    if (key < me->key) {
+        Node *l = remove(me->left, key, found);
+        return found ? balance(me->key, l, retain(me->right)) : nullptr;
+    }
+    if (me->key < key) {
+        Node *r = remove(me->right, key, found);
+        return found ? balance(me->key, retain(me->left), r) : nullptr;
+    }
+    found = true;
+    if (me->left == nullptr)
+        return retain(me->right);
+    if (me->right == nullptr)
+        return retain(me->left);
+    // my successor takes my place
+    const KeyType *min;
+    Node *r = removeMin(me->right, min);
+    return balance(*min, retain(me->left), r);
+}
+
+template<typename KeyType>
+typename PersistentBST<KeyType>::Node *PersistentBST<KeyType>::removeMin(Node *me, const KeyType *&min) {
+    if (me->left == nullptr) {
+        min = &me->key;
+        return retain(me->right);
+    }
+    Node *l = removeMin(me->left, min);
+    return balance(me->key, l, retain(me->right));
+}
+
+template<typename KeyType>
+std::string PersistentBST<KeyType>::getInOrderTraversal() const {
+    std::ostringstream ss;
+    forEachInOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType>
+std::string PersistentBST<KeyType>::getPreOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPreOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType>
+std::string PersistentBST<KeyType>::getPostOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPostOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType>
+template<typename Visit>
+void PersistentBST<KeyType>::forEachInOrder(Visit visit) const {
+    std::vector<const Node *> todo;
+    todo.reserve(Node::heightOf(root));
+    const Node *me = root;
+    while (me != nullptr || !todo.empty()) {
+        while (me != nullptr) {
+            todo.push_back(me);
+            me = me->left;
+        }
+        me = todo.back();
+        todo.pop_back();
+        visit(me->key);
+        me = me->right;
+    }
+}
+
+template<typename KeyType>
+template<typename Visit>
+void PersistentBST<KeyType>::forEachPreOrder(Visit visit) const {
+    std::vector<const Node *> todo;
+    todo.reserve(Node::heightOf(root));
+    if (root != nullptr)
+        todo.push_back(root);
+    while (!todo.empty()) {
+        const Node *me = todo.back();
+        todo.pop_back();
+        visit(me->key);
+        if (me->right != nullptr)
+            todo.push_back(me->right);
+        if (me->left != nullptr)
+            todo.push_back(me->left);
+    }
+}
+
+template<typename KeyType>
+template<typename Visit>
+void PersistentBST<KeyType>::forEachPostOrder(Visit visit) const {
+    std::vector<const Node *> todo;
+    todo.reserve(Node::heightOf(root));
+    const Node *me = root, *lastVisited = nullptr;
+    while (me != nullptr || !todo.empty()) {
+        if (me != nullptr) {
+            todo.push_back(me);
+            me = me->left;
+        } else {
+            const Node *top = todo.back();
+            if (top->right != nullptr && top->right != lastVisited) {
+                me = top->right;
+            } else {
+                visit(top->key);
+                lastVisited = top;
+                todo.pop_back();
+            }
+        }
+    }
+}
+
+#endif //PROJECT3_PERSISTENTBST_H
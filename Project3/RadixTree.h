@@ -0,0 +1,695 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_RADIXTREE_H
+#define PROJECT3_RADIXTREE_H
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @class RadixTree - compressed trie implementation of the Set ADT for
+ * string keys
+ *
+ * Drop-in replacement for BST<std::string> (has/add/remove/size/
+ * traversals). Each node holds the bytes of a run of the key that no
+ * other key branches off (its prefix), whether a key ends there, and one
+ * child per byte that follows. A lookup reads every byte of the probe at
+ * most once, so it costs O(key length) whatever the number of keys, and
+ * the keys sharing a prefix are exactly one subtree, which is what
+ * prefixScan() and countPrefix() use.
+ *
+ * The child table adapts to the fan-out: a sorted list of (byte, child)
+ * scanned in order while it is small, a direct 256-slot table once it
+ * grows past DENSE_AT children (and back below SPARSE_AT).
+ *
+ * A trie visits a key before every key it is a prefix of, so in-order
+ * and pre-order both list the keys in ascending order; post-order lists
+ * each key after its extensions. getLeafCount() and getHeight() count
+ * trie nodes and levels.
+ */
+class RadixTree {
+public:
+    /**
+     * Simple constructor creates an empty set.
+     */
+    RadixTree();
+
+    /**
+     * Destructor
+     */
+    ~RadixTree();
+
+    /**
+     * Copy constructor creates a copy of the set.
+     * @param other another RadixTree to copy
+     */
+    RadixTree(const RadixTree &other);
+
+    /**
+     * Assignment operator.
+     * Destroys current set and makes a copy of the rhs set.
+     * @param rhs  another RadixTree to copy
+     * @return *this
+     */
+    RadixTree &operator=(const RadixTree &rhs);
+
+    /**
+     * Move constructor takes over other's nodes; other is left empty.
+     */
+    RadixTree(RadixTree &&other) noexcept;
+
+    /**
+     * Move assignment; rhs is left empty.
+     */
+    RadixTree &operator=(RadixTree &&rhs) noexcept;
+
+    /**
+     * Determine if the given key is currently in this set. O(key length).
+     * @param key  possible element of this set
+     * @return     true if key is an element, false otherwise
+     */
+    bool has(std::string_view key) const;
+
+    /**
+     * Insert a new element into the set. O(key length).
+     * If the element was already in the set, this method does nothing.
+     * @param newKey to insert
+     * @post has(newKey) is true
+     */
+    void add(std::string_view newKey);
+
+    /**
+     * Remove the given key from this set. O(key length).
+     * @param key  an element (possibly) of this set
+     * @post       has(key) is false
+     */
+    void remove(std::string_view key);
+
+    /**
+     * Replace the contents of this set with the keys in [first, last),
+     * in any order and possibly repeated.
+     * @param first  start of the keys (convertible to string_view)
+     * @param last   end of the keys
+     */
+    template<typename InputIt>
+    void buildFrom(InputIt first, InputIt last);
+
+    /**
+     * Check if this is an empty set.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Count the number of elements in this set. O(1).
+     */
+    int size() const;
+
+    /**
+     * Count the elements that start with prefix. O(prefix length): every
+     * node keeps the number of keys below it.
+     * @param prefix  bytes every counted key starts with ("" counts all)
+     */
+    int countPrefix(std::string_view prefix) const;
+
+    /**
+     * Calls visit(key) on every element that starts with prefix, in
+     * ascending order, visiting only the subtree of those keys. The view
+     * is only valid during the call.
+     * @param prefix  bytes every visited key starts with
+     * @param visit   callable taking std::string_view
+     */
+    template<typename Visit>
+    void prefixScan(std::string_view prefix, Visit visit) const;
+
+    /**
+     * Count the trie nodes that have no children.
+     */
+    int getLeafCount() const;
+
+    /**
+     * Returns the number of levels of trie nodes; 0 when empty.
+     */
+    int getHeight() const;
+
+    /**
+     * Returns a string of elements in ascending order.
+     */
+    std::string getInOrderTraversal() const;
+
+    /**
+     * Returns a string of elements, each before its extensions (this is
+     * ascending order).
+     */
+    std::string getPreOrderTraversal() const;
+
+    /**
+     * Returns a string of elements, each after its extensions.
+     */
+    std::string getPostOrderTraversal() const;
+
+    /**
+     * Calls visit(key) on every element in ascending order.
+     * @param visit  callable taking std::string_view
+     */
+    template<typename Visit>
+    void forEachInOrder(Visit visit) const;
+
+    /**
+     * Same as forEachInOrder(): a trie's pre-order is ascending.
+     */
+    template<typename Visit>
+    void forEachPreOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element, each after its extensions.
+     * @param visit  callable taking std::string_view
+     */
+    template<typename Visit>
+    void forEachPostOrder(Visit visit) const;
+
+private:
+    /**
+     * A sparse child table turns dense when it would get more children
+     * than this, and a dense one sparse when it gets fewer than SPARSE_AT.
+     */
+    static const int DENSE_AT = 48;
+    static const int SPARSE_AT = 32;
+
+    struct Node;
+
+    /**
+     * A child and the byte that leads to it, kept side by side so finding
+     * a child reads one table.
+     */
+    struct Branch {
+        unsigned char byte;
+        Node *child;
+    };
+
+    struct Node {
+        std::string prefix;             // key bytes after the branch byte
+        std::vector<Branch> branches;   // ascending by byte (sparse), or
+                                        // branches[b] for byte b (dense)
+        int count;    // keys in this subtree, mine included
+        int fanout;   // children
+        bool terminal;  // a key ends here
+        bool dense;
+
+        Node(std::string_view prefix, bool terminal)
+                : prefix(prefix), count(terminal ? 1 : 0), fanout(0), terminal(terminal), dense(false) {}
+
+        /**
+         * The child following byte b, or nullptr.
+         */
+        Node *child(unsigned char b) const;
+
+        /**
+         * Add child n following byte b, which has no child yet.
+         */
+        void addChild(unsigned char b, Node *n);
+
+        /**
+         * Drop the child following byte b (not deleting it).
+         */
+        void removeChild(unsigned char b);
+
+        /**
+         * Children in ascending byte order: the child after position
+         * cursor (start at -1), with cursor and b moved to it, or nullptr
+         * after the last.
+         */
+        Node *nextChild(int &cursor, unsigned char &b) const;
+    };
+
+    /**
+     * The root, or nullptr for an empty set. Every node other than a
+     * terminal one has at least two children.
+     */
+    Node *root;
+
+    /**
+     * Scratch stack of the nodes walked by add() and remove(), kept as a
+     * member so its storage is reused from call to call.
+     */
+    std::vector<Node *> path;
+
+    /**
+     * Split me's prefix before position i: me keeps prefix[0, i) and gets
+     * a single child, after byte prefix[i], holding the rest of me.
+     */
+    static void split(Node *me, size_t i);
+
+    /**
+     * Absorb the only child of me, which is not terminal, into me.
+     */
+    static void merge(Node *me);
+
+    /**
+     * Find the node whose subtree holds exactly the keys starting with
+     * prefix.
+     * @param prefix  bytes to follow
+     * @param depth   receives how many bytes of keys lie above the node
+     * @return        that node, or nullptr if no key starts with prefix
+     */
+    const Node *findPrefix(std::string_view prefix, size_t &depth) const;
+
+    /**
+     * Visit the keys of the subtree under start, key holding the bytes
+     * above it, each before (ascending) or after its extensions.
+     */
+    template<typename Visit>
+    static void walk(const Node *start, std::string &key, bool postOrder, Visit visit);
+
+    /**
+     * Delete a subtree using an explicit stack.
+     */
+    static void clear(Node *me);
+
+    /**
+     * Copy a subtree using an explicit stack.
+     */
+    static Node *copy(const Node *me);
+};
+
+inline RadixTree::RadixTree() : root(nullptr) {
+}
+
+inline RadixTree::~RadixTree() {
+    clear(root);
+}
+
+inline RadixTree::RadixTree(const RadixTree &other) : root(copy(other.root)) {
+}
+
+inline RadixTree &RadixTree::operator=(const RadixTree &rhs) {
+    if (this != &rhs) {
+        Node *fresh = copy(rhs.root);
+        clear(root);
+        root = fresh;
+    }
+    return *this;
+}
+
+inline RadixTree::RadixTree(RadixTree &&other) noexcept : root(other.root) {
+    other.root = nullptr;
+}
+
+inline RadixTree &RadixTree::operator=(RadixTree &&rhs) noexcept {
+    if (this != &rhs) {
+        clear(root);
+        root = rhs.root;
+        rhs.root = nullptr;
+    }
+    return *this;
+}
+
+inline bool RadixTree::has(std::string_view key) const {
+    const Node *me = root;
+    size_t pos = 0;
+    while (me != nullptr) {
+        size_t len = me->prefix.size();
+        if (key.size() - pos < len || std::memcmp(key.data() + pos, me->prefix.data(), len) != 0)
+            return false;
+        pos += len;
+        if (pos == key.size())
+            return me->terminal;
+        me = me->child(static_cast<unsigned char>(key[pos]));
+        ++pos;
+    }
+    return false;
+}
+
+inline void RadixTree::add(std::string_view newKey) {
+    if (root == nullptr) {
+        root = new Node(newKey, true);
+        return;
+    }
+    path.clear();
+    Node *me = root;
+    size_t pos = 0;
+    while (true) {
+        size_t len = me->prefix.size();
+        size_t limit = std::min(len, newKey.size() - pos);
+        size_t i = 0;
+        while (i < limit && me->prefix[i] == newKey[pos + i])
+            ++i;
+        if (i < len)
+            split(me, i); // newKey branches off inside my prefix
+        pos += i;
+        path.push_back(me);
+        if (pos == newKey.size()) {
+            if (me->terminal) {
+                path.clear();
+                return; // already an element
+            }
+            me->terminal = true;
+            break;
+        }
+        unsigned char b = static_cast<unsigned char>(newKey[pos]);
+        Node *next = me->child(b);
+        if (next == nullptr) {
+            me->addChild(b, new Node(newKey.substr(pos + 1), true));
+            break;
+        }
+        me = next;
+        ++pos;
+    }
+    for (Node *n : path)
+        ++n->count;
+    path.clear();
+}
+
+inline void RadixTree::remove(std::string_view key) {
+    path.clear();
+    Node *me = root, *parent = nullptr;
+    unsigned char parentByte = 0;
+    size_t pos = 0;
+    bool found = false;
+    while (me != nullptr) {
+        size_t len = me->prefix.size();
+        if (key.size() - pos < len || std::memcmp(key.data() + pos, me->prefix.data(), len) != 0)
+            break;
+        pos += len;
+        path.push_back(me);
+        if (pos == key.size()) {
+            found = me->terminal;
+            break;
+        }
+        parent = me;
+        parentByte = static_cast<unsigned char>(key[pos]);
+        me = me->child(parentByte);
+        ++pos;
+    }
+    if (!found) {
+        path.clear();
+        return; // not an element
+    }
+
+    for (Node *n : path)
+        --n->count;
+    path.clear();
+    me->terminal = false;
+    if (me->fanout == 0) {
+        delete me;
+        if (parent == nullptr) {
+            root = nullptr;
+            return;
+        }
+        parent->removeChild(parentByte);
+        if (!parent->terminal && parent->fanout == 1)
+            merge(parent);
+    } else if (me->fanout == 1) {
+        merge(me);
+    }
+}
+
+template<typename InputIt>
+void RadixTree::buildFrom(InputIt first, InputIt last) {
+    clear(root);
+    root = nullptr;
+    for (; first != last; ++first)
+        add(std::string_view(*first));
+}
+
+inline bool RadixTree::isEmpty() const {
+    return root == nullptr;
+}
+
+inline int RadixTree::size() const {
+    return root == nullptr ? 0 : root->count;
+}
+
+inline int RadixTree::countPrefix(std::string_view prefix) const {
+    size_t depth;
+    const Node *me = findPrefix(prefix, depth);
+    return me == nullptr ? 0 : me->count;
+}
+
+template<typename Visit>
+void RadixTree::prefixScan(std::string_view prefix, Visit visit) const {
+    size_t depth;
+    const Node *me = findPrefix(prefix, depth);
+    if (me == nullptr)
+        return;
+    std::string key(prefix.substr(0, depth));
+    walk(me, key, false, visit);
+}
+
+inline int RadixTree::getLeafCount() const {
+    int leaves = 0;
+    std::vector<const Node *> todo;
+    if (root != nullptr)
+        todo.push_back(root);
+    while (!todo.empty()) {
+        const Node *n = todo.back();
+        todo.pop_back();
+        if (n->fanout == 0)
+            ++leaves;
+        int cursor = -1;
+        unsigned char b;
+        while (const Node *c = n->nextChild(cursor, b))
+            todo.push_back(c);
+    }
+    return leaves;
+}
+
+inline int RadixTree::getHeight() const {
+    int height = 0;
+    std::vector<std::pair<const Node *, int>> todo;
+    if (root != nullptr)
+        todo.emplace_back(root, 1);
+    while (!todo.empty()) {
+        const Node *n = todo.back().first;
+        int level = todo.back().second;
+        todo.pop_back();
+        height = std::max(height, level);
+        int cursor = -1;
+        unsigned char b;
+        while (const Node *c = n->nextChild(cursor, b))
+            todo.emplace_back(c, level + 1);
+    }
+    return height;
+}
+
+inline std::string RadixTree::getInOrderTraversal() const {
+    std::ostringstream ss;
+    forEachInOrder([&ss](std::string_view key) { ss << key << " "; });
+    return ss.str();
+}
+
+inline std::string RadixTree::getPreOrderTraversal() const {
+    return getInOrderTraversal();
+}
+
+inline std::string RadixTree::getPostOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPostOrder([&ss](std::string_view key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename Visit>
+void RadixTree::forEachInOrder(Visit visit) const {
+    std::string key;
+    if (root != nullptr)
+        walk(root, key, false, visit);
+}
+
+template<typename Visit>
+void RadixTree::forEachPreOrder(Visit visit) const {
+    forEachInOrder(visit);
+}
+
+template<typename Visit>
+void RadixTree::forEachPostOrder(Visit visit) const {
+    std::string key;
+    if (root != nullptr)
+        walk(root, key, true, visit);
+}
+
+inline RadixTree::Node *RadixTree::Node::child(unsigned char b) const {
+    if (dense)
+        return branches[b].child;
+    for (const Branch &branch : branches)
+        if (branch.byte >= b)
+            return branch.byte == b ? branch.child : nullptr;
+    return nullptr;
+}
+
+inline void RadixTree::Node::addChild(unsigned char b, Node *n) {
+    ++fanout;
+    if (dense) {
+        branches[b].child = n;
+        return;
+    }
+    auto at = std::lower_bound(branches.begin(), branches.end(), b,
+                               [](const Branch &branch, unsigned char key) { return branch.byte < key; });
+    branches.insert(at, Branch{b, n});
+    if (fanout > DENSE_AT) {
+        std::vector<Branch> slots(256);
+        for (int k = 0; k < 256; k++)
+            slots[k] = Branch{static_cast<unsigned char>(k), nullptr};
+        for (const Branch &branch : branches)
+            slots[branch.byte].child = branch.child;
+        branches.swap(slots);
+        dense = true;
+    }
+}
+
+inline void RadixTree::Node::removeChild(unsigned char b) {
+    --fanout;
+    if (dense) {
+        branches[b].child = nullptr;
+        if (fanout < SPARSE_AT) {
+            std::vector<Branch> list;
+            list.reserve(DENSE_AT);
+            for (const Branch &branch : branches)
+                if (branch.child != nullptr)
+                    list.push_back(branch);
+            branches.swap(list);
+            dense = false;
+        }
+        return;
+    }
+    branches.erase(std::lower_bound(branches.begin(), branches.end(), b,
+                                    [](const Branch &branch, unsigned char key) { return branch.byte < key; }));
+}
+
+inline RadixTree::Node *RadixTree::Node::nextChild(int &cursor, unsigned char &b) const {
+    if (dense) {
+        while (++cursor < 256) {
+            if (branches[cursor].child != nullptr) {
+                b = branches[cursor].byte;
+                return branches[cursor].child;
+            }
+        }
+        return nullptr;
+    }
+    if (++cursor >= static_cast<int>(branches.size()))
+        return nullptr;
+    b = branches[cursor].byte;
+    return branches[cursor].child;
+}
+
+inline void RadixTree::split(Node *me, size_t i) {
+    Node *lower = new Node(std::string_view(me->prefix).substr(i + 1), me->terminal);
+    lower->count = me->count;
+    lower->fanout = me->fanout;
+    lower->dense = me->dense;
+    lower->branches.swap(me->branches);
+    unsigned char b = static_cast<unsigned char>(me->prefix[i]);
+    me->prefix.resize(i);
+    me->terminal = false;
+    me->fanout = 0;
+    me->dense = false;
+    me->addChild(b, lower);
+}
+
+inline void RadixTree::merge(Node *me) {
+    int cursor = -1;
+    unsigned char b = 0;
+    Node *only = me->nextChild(cursor, b);
+    me->prefix.push_back(static_cast<char>(b));
+    me->prefix.append(only->prefix);
+    me->terminal = only->terminal;
+    me->fanout = only->fanout;
+    me->dense = only->dense;
+    me->branches.swap(only->branches);
+    delete only;
+}
+
+inline const RadixTree::Node *RadixTree::findPrefix(std::string_view prefix, size_t &depth) const {
+    const Node *me = root;
+    size_t pos = 0;
+    while (me != nullptr) {
+        size_t len = me->prefix.size();
+        size_t rest = prefix.size() - pos;
+        if (std::memcmp(prefix.data() + pos, me->prefix.data(), std::min(len, rest)) != 0)
+            return nullptr;
+        if (rest <= len) {
+            depth = pos;
+            return me; // prefix ends inside (or right after) my run
+        }
+        pos += len;
+        me = me->child(static_cast<unsigned char>(prefix[pos]));
+        ++pos;
+    }
+    return nullptr;
+}
+
+template<typename Visit>
+void RadixTree::walk(const Node *start, std::string &key, bool postOrder, Visit visit) {
+    struct Frame {
+        const Node *node;
+        int cursor;     // last child visited, see Node::nextChild
+        size_t length;  // of key at this node, prefix included
+    };
+    std::vector<Frame> todo;
+    auto enter = [&](const Node *n) {
+        key.append(n->prefix);
+        if (n->terminal && !postOrder)
+            visit(std::string_view(key));
+        todo.push_back(Frame{n, -1, key.size()});
+    };
+    enter(start);
+    while (!todo.empty()) {
+        Frame &top = todo.back();
+        unsigned char b;
+        const Node *next = top.node->nextChild(top.cursor, b);
+        key.resize(top.length);
+        if (next != nullptr) {
+            key.push_back(static_cast<char>(b));
+            enter(next);
+        } else {
+            if (top.node->terminal && postOrder)
+                visit(std::string_view(key));
+            todo.pop_back();
+        }
+    }
+}
+
+inline void RadixTree::clear(Node *me) {
+    std::vector<Node *> todo;
+    if (me != nullptr)
+        todo.push_back(me);
+    while (!todo.empty()) {
+        Node *n = todo.back();
+        todo.pop_back();
+        int cursor = -1;
+        unsigned char b;
+        while (Node *c = n->nextChild(cursor, b))
+            todo.push_back(c);
+        delete n;
+    }
+}
+
+inline RadixTree::Node *RadixTree::copy(const Node *me) {
+    Node *result = nullptr;
+    std::vector<std::pair<const Node *, Node **>> todo;
+    if (me != nullptr)
+        todo.emplace_back(me, &result);
+    while (!todo.empty()) {
+        const Node *src = todo.back().first;
+        Node **dst = todo.back().second;
+        todo.pop_back();
+
+        Node *n = new Node(src->prefix, src->terminal);
+        n->count = src->count;
+        n->fanout = src->fanout;
+        n->dense = src->dense;
+        n->branches = src->branches;
+        *dst = n;
+        for (Branch &branch : n->branches)
+            if (branch.child != nullptr)
+                todo.emplace_back(branch.child, &branch.child);
+    }
+    return result;
+}
+
+#endif //PROJECT3_RADIXTREE_H
@@ -0,0 +1,541 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_SPLAYBST_H
+#define PROJECT3_SPLAYBST_H
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "NodePool.h"
+
+/**
+ * @class SplayBST - self-adjusting Set ADT for skewed workloads
+ *
+ * Every has(), add() and remove() splays: the node it ends on (the key,
+ * or the last node before the key's empty slot) is rotated up to the
+ * root, and the nodes on the way move up about half their depth. Keys
+ * asked for again soon after are therefore found within a few levels, and
+ * so are misses close to them; any sequence of m operations costs
+ * O((m + n) log n) however bad a single one may be.
+ *
+ * Splaying is top-down (Sleator and Tarjan): one pass from the root splits
+ * the nodes passed into a left and a right tree and reassembles them under
+ * the final node, with no recursion and no parent pointers, so the
+ * degenerate trees sorted access produces cost no stack.
+ *
+ * Since has() restructures the tree, it is not const and, unlike BST,
+ * even concurrent readers of one SplayBST must be serialized.
+ * Nodes keep no height or count, so getHeight() and getLeafCount() walk
+ * the tree.
+ *
+ * @tparam KeyType    element type, ordered by operator<
+ * @tparam Allocator  node allocator policy, as for BST
+ */
+template<typename KeyType, template<typename> class Allocator = NodePool>
+class SplayBST {
+public:
+    /**
+     * Simple constructor creates an empty set.
+     */
+    SplayBST();
+
+    /**
+     * Destructor. Frees all nodes.
+     */
+    ~SplayBST();
+
+    /**
+     * Copy constructor, copying other's shape as it stands.
+     * @param other another SplayBST to copy
+     */
+    SplayBST(const SplayBST &other);
+
+    /**
+     * Assignment operator.
+     * Destroys current set and makes a copy of the rhs set.
+     * @param rhs  another SplayBST to copy
+     * @return *this
+     */
+    SplayBST &operator=(const SplayBST &rhs);
+
+    SplayBST(SplayBST &&other) noexcept;
+
+    SplayBST &operator=(SplayBST &&rhs) noexcept;
+
+    /**
+     * Determine if the given key is in this set, splaying it (or the
+     * last node on its search path) to the root.
+     * @param key  possible element of this set
+     * @return     true if key is an element, false otherwise
+     */
+    bool has(const KeyType &key);
+
+    /**
+     * Insert a new element into the set; it becomes the root.
+     * If the element was already in the set, it is only splayed.
+     * @param newKey to insert
+     * @post has(newKey) is true
+     */
+    void add(const KeyType &newKey);
+
+    /**
+     * Remove the given key from this set. Its predecessor, if any,
+     * takes its place at the root.
+     * @param key  an element (possibly) of this set
+     * @post       has(key) is false
+     */
+    void remove(const KeyType &key);
+
+    /**
+     * Replace the contents of this set with the distinct keys of
+     * [first, last), in any order, as a tree of minimum height.
+     * @param first  start of the keys
+     * @param last   end of the keys
+     */
+    template<typename InputIt>
+    void buildFrom(InputIt first, InputIt last);
+
+    /**
+     * Check if this is an empty set.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Count the number of elements in this set. O(1).
+     */
+    int size() const;
+
+    /**
+     * Count the leaves of the tree. O(n).
+     */
+    int getLeafCount() const;
+
+    /**
+     * Returns the number of levels of the tree as it currently stands;
+     * 0 when empty. O(n).
+     */
+    int getHeight() const;
+
+    std::string getInOrderTraversal() const;
+
+    std::string getPreOrderTraversal() const;
+
+    std::string getPostOrderTraversal() const;
+
+    /**
+     * Calls visit(key) on every element in ascending order.
+     * @param visit  callable taking const KeyType &
+     */
+    template<typename Visit>
+    void forEachInOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in pre-order order.
+     */
+    template<typename Visit>
+    void forEachPreOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in post-order order.
+     */
+    template<typename Visit>
+    void forEachPostOrder(Visit visit) const;
+
+private:
+    struct Node {
+        KeyType key;
+        Node *left, *right;
+
+        template<typename... Args>
+        explicit Node(Args &&... args)
+                : key(std::forward<Args>(args)...), left(nullptr), right(nullptr) {}
+    };
+
+    Node *root;
+
+    /**
+     * Number of elements.
+     */
+    int count;
+
+    /**
+     * Source of every Node in this set.
+     */
+    Allocator<Node> alloc;
+
+    /**
+     * Top-down splay of key in the subtree me.
+     * @param me   subtree root, not nullptr
+     * @param key  key to look for
+     * @return     the new subtree root: key's node if key is in me,
+     *             otherwise its in-order predecessor or successor
+     */
+    static Node *splay(Node *me, const KeyType &key);
+
+    /**
+     * True if a and b are the same key under operator<.
+     */
+    static bool same(const KeyType &a, const KeyType &b);
+
+    /**
+     * Helper method for buildFrom: a minimum-height subtree from the
+     * next n keys of next, advancing next past them.
+     */
+    template<typename ForwardIt>
+    Node *buildSorted(ForwardIt &next, int n);
+
+    /**
+     * Free every node of the subtree me, iteratively.
+     */
+    void clear(Node *me);
+
+    /**
+     * A copy of the subtree me from this set's allocator, iteratively.
+     */
+    Node *copy(const Node *me);
+};
+
+template<typename KeyType, template<typename> class Allocator>
+SplayBST<KeyType, Allocator>::SplayBST() : root(nullptr), count(0) {
+}
+
+template<typename KeyType, template<typename> class Allocator>
+SplayBST<KeyType, Allocator>::~SplayBST() {
+    clear(root);
+}
+
+template<typename KeyType, template<typename> class Allocator>
+SplayBST<KeyType, Allocator>::SplayBST(const SplayBST &other) : root(nullptr), count(other.count) {
+    root = copy(other.root);
+}
+
+template<typename KeyType, template<typename> class Allocator>
+SplayBST<KeyType, Allocator> &SplayBST<KeyType, Allocator>::operator=(const SplayBST &rhs) {
+    if (this != &rhs) {
+        clear(root);
+        root = copy(rhs.root);
+        count = rhs.count;
+    }
+    return *this;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+SplayBST<KeyType, Allocator>::SplayBST(SplayBST &&other) noexcept
+        : root(other.root), count(other.count), alloc(std::move(other.alloc)) {
+    other.root = nullptr;
+    other.count = 0;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+SplayBST<KeyType, Allocator> &SplayBST<KeyType, Allocator>::operator=(SplayBST &&rhs) noexcept {
+    if (this != &rhs) {
+        clear(root);
+        alloc = std::move(rhs.alloc);
+        root = rhs.root;
+        count = rhs.count;
+        rhs.root = nullptr;
+        rhs.count = 0;
+    }
+    return *this;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+bool SplayBST<KeyType, Allocator>::has(const KeyType &key) {
+    if (root == nullptr)
+        return false;
+    root = splay(root, key);
+    return same(root->key, key);
+}
+
+template<typename KeyType, template<typename> class Allocator>
+void SplayBST<KeyType, Allocator>::add(const KeyType &newKey) {
+    if (root != nullptr) {
+        root = splay(root, newKey);
+        if (same(root->key, newKey))
+            return; // already an element
+    }
+    Node *fresh = alloc.create(newKey);
+    if (root != nullptr) {
+        // root is newKey's neighbour, so one of its sides goes under fresh
+        if (newKey < root->key) {
+            fresh->left = root->left;
+            fresh->right = root;
+            root->left = nullptr;
+        } else {
+            fresh->right = root->right;
+            fresh->left = root;
+            root->right = nullptr;
+        }
+    }
+    root = fresh;
+    ++count;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+void SplayBST<KeyType, Allocator>::remove(const KeyType &key) {
+    if (root == nullptr)
+        return;
+    root = splay(root, key);
+    if (!same(root->key, key))
+        return; // not an element
+    Node *target = root;
+    if (target->left == nullptr) {
+        root = target->right;
+    } else {
+        // key is above everything on the left, so splaying it there
+        // brings up the maximum, which has no right child
+        root = splay(target->left, key);
+        root->right = target->right;
+    }
+    alloc.destroy(target);
+    --count;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+template<typename InputIt>
+void SplayBST<KeyType, Allocator>::buildFrom(InputIt first, InputIt last) {
+    std::vector<KeyType> keys(first, last);
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end(), same), keys.end());
+    clear(root);
+    auto next = keys.cbegin();
+    count = static_cast<int>(keys.size());
+    root = buildSorted(next, count);
+}
+
+template<typename KeyType, template<typename> class Allocator>
+bool SplayBST<KeyType, Allocator>::isEmpty() const {
+    return root == nullptr;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+int SplayBST<KeyType, Allocator>::size() const {
+    return count;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+int SplayBST<KeyType, Allocator>::getLeafCount() const {
+    int leaves = 0;
+    std::vector<const Node *> todo;
+    if (root != nullptr)
+        todo.push_back(root);
+    while (!todo.empty()) {
+        const Node *n = todo.back();
+        todo.pop_back();
+        if (n->left == nullptr && n->right == nullptr)
+            ++leaves;
+        if (n->left != nullptr)
+            todo.push_back(n->left);
+        if (n->right != nullptr)
+            todo.push_back(n->right);
+    }
+    return leaves;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+int SplayBST<KeyType, Allocator>::getHeight() const {
+    int height = 0;
+    std::vector<std::pair<const Node *, int>> todo;
+    if (root != nullptr)
+        todo.emplace_back(root, 1);
+    while (!todo.empty()) {
+        const Node *n = todo.back().first;
+        int level = todo.back().second;
+        todo.pop_back();
+        height = std::max(height, level);
+        if (n->left != nullptr)
+            todo.emplace_back(n->left, level + 1);
+        if (n->right != nullptr)
+            todo.emplace_back(n->right, level + 1);
+    }
+    return height;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+typename SplayBST<KeyType, Allocator>::Node *SplayBST<KeyType, Allocator>::splay(Node *me, const KeyType &key) {
+    // nodes found smaller than key collect in a tree hung from leftTree,
+    // larger ones in rightTree; leftHook and rightHook are the empty
+    // links where the next of each goes (the largest and smallest slots)
+    Node *leftTree = nullptr, *rightTree = nullptr;
+    Node **leftHook = &leftTree, **rightHook = &rightTree;
+    for (;;) {
+        if (key < me->key) {
+            if (me->left == nullptr)
+                break;
+            if (key < me->left->key) {
+                // zig-zig: rotate right before linking
+                Node *child = me->left;
+                me->left = child->right;
+                child->right = me;
+                me = child;
+                if (me->left == nullptr)
+                    break;
+            }
+            *rightHook = me;
+            rightHook = &me->left;
+            me = me->left;
+        } else if (me->key < key) {
+            if (me->right == nullptr)
+                break;
+            if (me->right->key < key) {
+                // zig-zig: rotate left before linking
+                Node *child = me->right;
+                me->right = child->left;
+                child->left = me;
+                me = child;
+                if (me->right == nullptr)
+                    break;
+            }
+            *leftHook = me;
+            leftHook = &me->right;
+            me = me->right;
+        } else {
+            break;
+        }
+    }
+    *leftHook = me->left;
+    *rightHook = me->right;
+    me->left = leftTree;
+    me->right = rightTree;
+    return me;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+bool SplayBST<KeyType, Allocator>::same(const KeyType &a, const KeyType &b) {
+    return !(a < b) && !(b < a);
+}
+
+template<typename KeyType, template<typename> class Allocator>
+template<typename ForwardIt>
+typename SplayBST<KeyType, Allocator>::Node *SplayBST<KeyType, Allocator>::buildSorted(ForwardIt &next, int n) {
+    if (n == 0)
+        return nullptr;
+    int leftCount = n / 2;
+    Node *left = buildSorted(next, leftCount);
+    Node *me = alloc.create(*next);
+    ++next;
+    me->left = left;
+    me->right = buildSorted(next, n - leftCount - 1);
+    return me;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+void SplayBST<KeyType, Allocator>::clear(Node *me) {
+    while (me != nullptr) {
+        if (me->left != nullptr) {
+            Node *pivot = me->left;
+            me->left = pivot->right;
+            pivot->right = me;
+            me = pivot;
+        } else {
+            Node *next = me->right;
+            alloc.destroy(me);
+            me = next;
+        }
+    }
+}
+
+template<typename KeyType, template<typename> class Allocator>
+typename SplayBST<KeyType, Allocator>::Node *SplayBST<KeyType, Allocator>::copy(const Node *me) {
+    Node *result = nullptr;
+    std::vector<std::pair<const Node *, Node **>> todo;
+    if (me != nullptr)
+        todo.emplace_back(me, &result);
+    while (!todo.empty()) {
+        const Node *src = todo.back().first;
+        Node **dst = todo.back().second;
+        todo.pop_back();
+
+        Node *n = alloc.create(src->key);
+        *dst = n;
+        if (src->right != nullptr)
+            todo.emplace_back(src->right, &n->right);
+        if (src->left != nullptr)
+            todo.emplace_back(src->left, &n->left);
+    }
+    return result;
+}
+
+template<typename KeyType, template<typename> class Allocator>
+std::string SplayBST<KeyType, Allocator>::getInOrderTraversal() const {
+    std::ostringstream ss;
+    forEachInOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType, template<typename> class Allocator>
+std::string SplayBST<KeyType, Allocator>::getPreOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPreOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType, template<typename> class Allocator>
+std::string SplayBST<KeyType, Allocator>::getPostOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPostOrder([&ss](const KeyType &key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename KeyType, template<typename> class Allocator>
+template<typename Visit>
+void SplayBST<KeyType, Allocator>::forEachInOrder(Visit visit) const {
+    std::vector<const Node *> todo;
+    const Node *me = root;
+    while (me != nullptr || !todo.empty()) {
+        while (me != nullptr) {
+            todo.push_back(me);
+            me = me->left;
+        }
+        me = todo.back();
+        todo.pop_back();
+        visit(me->key);
+        me = me->right;
+    }
+}
+
+template<typename KeyType, template<typename> class Allocator>
+template<typename Visit>
+void SplayBST<KeyType, Allocator>::forEachPreOrder(Visit visit) const {
+    std::vector<const Node *> todo;
+    if (root != nullptr)
+        todo.push_back(root);
+    while (!todo.empty()) {
+        const Node *me = todo.back();
+        todo.pop_back();
+        visit(me->key);
+        if (me->right != nullptr)
+            todo.push_back(me->right);
+        if (me->left != nullptr)
+            todo.push_back(me->left);
+    }
+}
+
+template<typename KeyType, template<typename> class Allocator>
+template<typename Visit>
+void SplayBST<KeyType, Allocator>::forEachPostOrder(Visit visit) const {
+    std::vector<const Node *> todo;
+    const Node *me = root, *lastVisited = nullptr;
+    while (me != nullptr || !todo.empty()) {
+        if (me != nullptr) {
+            todo.push_back(me);
+            me = me->left;
+        } else {
+            const Node *top = todo.back();
+            if (top->right != nullptr && top->right != lastVisited) {
+                me = top->right;
+            } else {
+                visit(top->key);
+                lastVisited = top;
+                todo.pop_back();
+            }
+        }
+    }
+}
+
+#endif //PROJECT3_SPLAYBST_H
@@ -0,0 +1,850 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+#ifndef PROJECT3_STRINGBST_H
+#define PROJECT3_STRINGBST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "BSTBalance.h"
+#include "NodePool.h"
+#include "ParallelSort.h"
+
+/**
+ * @class KeyArena - append-only byte storage for the key tails of a
+ * StringBST
+ *
+ * Bytes are copied into large chunks, so a key costs no allocation of its
+ * own and keys added together sit next to each other. Released bytes are
+ * only counted; StringBST compacts the arena once they outweigh the live
+ * ones.
+ */
+class KeyArena {
+public:
+    KeyArena() = default;
+
+    ~KeyArena() {
+        for (char *chunk : chunks)
+            ::operator delete(chunk);
+    }
+
+    KeyArena(const KeyArena &) = delete;
+
+    KeyArena &operator=(const KeyArena &) = delete;
+
+    KeyArena(KeyArena &&other) noexcept {
+        swap(other);
+    }
+
+    KeyArena &operator=(KeyArena &&rhs) noexcept {
+        swap(rhs);
+        return *this;
+    }
+
+    /**
+     * Copy length bytes from bytes into the arena.
+     * @return  where the copy lives until the arena is destroyed
+     */
+    const char *store(const char *bytes, size_t length) {
+        char *to;
+        if (length > CHUNK / 4) {
+            // too big to share a chunk; the current chunk stays current
+            to = static_cast<char *>(::operator new(length));
+            chunks.insert(chunks.end() - (chunks.empty() ? 0 : 1), to);
+        } else {
+            if (static_cast<size_t>(end - next) < length) {
+                next = static_cast<char *>(::operator new(CHUNK));
+                end = next + CHUNK;
+                chunks.push_back(next);
+            }
+            to = next;
+            next += length;
+        }
+        std::memcpy(to, bytes, length);
+        live += length;
+        return to;
+    }
+
+    /**
+     * Note that length bytes handed out by store() are no longer used.
+     */
+    void release(size_t length) {
+        live -= length;
+        dead += length;
+    }
+
+    /**
+     * Bytes stored and not released.
+     */
+    size_t liveBytes() const {
+        return live;
+    }
+
+    /**
+     * Bytes released but still held.
+     */
+    size_t deadBytes() const {
+        return dead;
+    }
+
+    void swap(KeyArena &other) noexcept {
+        chunks.swap(other.chunks);
+        std::swap(next, other.next);
+        std::swap(end, other.end);
+        std::swap(live, other.live);
+        std::swap(dead, other.dead);
+    }
+
+private:
+    static constexpr size_t CHUNK = 64 * 1024;
+
+    std::vector<char *> chunks;
+    char *next = nullptr, *end = nullptr;
+    size_t live = 0, dead = 0;
+};
+
+/**
+ * @class StringBST - BST<std::string> with the keys kept out of the nodes
+ *
+ * The same Set ADT, shape and balancing policies as BST<std::string>, but
+ * a node holds the first INLINE bytes of its key in place, and only the
+ * rest of a longer key goes to the tree's KeyArena. Most comparisons are
+ * settled by comparing the inline prefixes as one big-endian integer,
+ * without leaving the node; only keys sharing their first INLINE bytes
+ * go on to compare tails. A key is never a std::string here, so adding
+ * one costs at most a node and an arena copy, never a heap allocation.
+ *
+ * Keys are taken and handed out as std::string_view. Keys order like
+ * std::string (bytewise, unsigned), and TreapBalance ranks them by the
+ * same hash, so the two trees built from the same keys in the same order
+ * have the same shape under every policy.
+ *
+ * @tparam Balance    balancing policy from BSTBalance.h
+ * @tparam Allocator  node allocation policy from NodePool.h
+ */
+template<typename Balance = Unbalanced, template<typename> class Allocator = NodePool>
+class StringBST {
+public:
+    /**
+     * Bytes of every key kept inside its node.
+     */
+    static constexpr size_t INLINE = 8;
+
+    /**
+     * Simple constructor creates an empty set.
+     */
+    StringBST();
+
+    /**
+     * Destructor
+     */
+    ~StringBST();
+
+    /**
+     * Copy constructor creates a copy of the set, with its own arena.
+     * @param other another StringBST to copy
+     */
+    StringBST(const StringBST &other);
+
+    /**
+     * Assignment operator.
+     * Destroys current set and makes a copy of the rhs set.
+     * @param rhs  another StringBST to copy
+     * @return *this
+     */
+    StringBST &operator=(const StringBST &rhs);
+
+    /**
+     * Move constructor takes over other's nodes and arena; other is left
+     * empty.
+     */
+    StringBST(StringBST &&other) noexcept;
+
+    /**
+     * Move assignment. Destroys current set and takes over rhs's nodes
+     * and arena; rhs is left empty.
+     */
+    StringBST &operator=(StringBST &&rhs) noexcept;
+
+    /**
+     * Determine if the given key is currently in this set
+     * @param key  possible element of this set
+     * @return     true if key is an element, false otherwise
+     */
+    bool has(std::string_view key) const;
+
+    /**
+     * Insert a new element into the set; its bytes are copied.
+     * If the element was already in the set, this method does nothing.
+     * @param newKey to insert
+     * @post has(newKey) is true
+     */
+    void add(std::string_view newKey);
+
+    /**
+     * Replace the contents of this set with the keys in [first, last),
+     * which must be strictly ascending. Builds a tree of minimum height in
+     * O(n), with the tails stored in key order, then relinks it in O(n) if
+     * the policy wants another shape (a treap).
+     * @param first  start of the sorted keys (convertible to string_view)
+     * @param last   end of the sorted keys
+     */
+    template<typename ForwardIt>
+    void assignSorted(ForwardIt first, ForwardIt last);
+
+    /**
+     * Replace the contents of this set with the keys in [first, last),
+     * in any order and possibly repeated, like BST::buildFrom(). Only
+     * views of the keys are sorted; the bytes are copied once.
+     * @param first  start of the keys (convertible to string_view)
+     * @param last   end of the keys
+     */
+    template<typename InputIt>
+    void buildFrom(InputIt first, InputIt last);
+
+    /**
+     * Remove the given key from this set
+     * @param key  an element (possibly) of this set
+     * @post       has(key) is false
+     */
+    void remove(std::string_view key);
+
+    /**
+     * Check if this is an empty set.
+     */
+    bool isEmpty() const;
+
+    /**
+     * Count the number of elements in this set. O(1).
+     */
+    int size() const;
+
+    /**
+     * Count the number of leaves in this set.
+     */
+    int getLeafCount() const;
+
+    /**
+     * Returns height of the tree; 0 when empty, 1 with one element.
+     */
+    int getHeight() const;
+
+    /**
+     * Bytes of key storage in use: the arena bytes held for tails, live
+     * or not yet compacted away. The inline prefixes are part of the nodes.
+     */
+    size_t arenaBytes() const;
+
+    /**
+     * Returns a string of elements in in-order (ascending) order.
+     */
+    std::string getInOrderTraversal() const;
+
+    /**
+     * Returns a string of elements in pre-order order.
+     */
+    std::string getPreOrderTraversal() const;
+
+    /**
+     * Returns a string of elements in post-order order.
+     */
+    std::string getPostOrderTraversal() const;
+
+    /**
+     * Calls visit(key) on every element in in-order (ascending) order.
+     * The view is only valid during the call.
+     * @param visit  callable taking std::string_view
+     */
+    template<typename Visit>
+    void forEachInOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in pre-order order.
+     * @param visit  callable taking std::string_view
+     */
+    template<typename Visit>
+    void forEachPreOrder(Visit visit) const;
+
+    /**
+     * Calls visit(key) on every element in post-order order.
+     * @param visit  callable taking std::string_view
+     */
+    template<typename Visit>
+    void forEachPostOrder(Visit visit) const;
+
+private:
+    /**
+     * A key to compare against nodes, with its inline prefix worked out
+     * once up front.
+     */
+    struct Probe {
+        uint64_t prefix;
+        std::string_view key;
+
+        explicit Probe(std::string_view key) : prefix(prefixOf(key.data(), key.size())), key(key) {}
+    };
+
+    struct Node {
+        uint64_t prefix;     // first INLINE bytes, big-endian, zero-padded
+        const char *tail;    // bytes past INLINE in the arena, or nullptr
+        uint32_t length;
+        int height;
+        int count;  // nodes in this subtree, me included
+        Node *left, *right;
+
+        Node(uint64_t prefix, const char *tail, uint32_t length)
+                : prefix(prefix), tail(tail), length(length), left(nullptr), right(nullptr) {
+            update();
+        }
+
+        static int heightOf(const Node *n) {
+            return n == nullptr ? 0 : n->height;
+        }
+
+        static int countOf(const Node *n) {
+            return n == nullptr ? 0 : n->count;
+        }
+
+        /**
+         * Recompute the cached height and count from the children's.
+         */
+        void update() {
+            int lHeight = heightOf(left);
+            int rHeight = heightOf(right);
+            height = (lHeight > rHeight ? lHeight : rHeight) + 1;
+            count = countOf(left) + countOf(right) + 1;
+        }
+
+        bool isLeaf() const {
+            return left == nullptr && right == nullptr;
+        }
+
+        /**
+         * std::hash of n's key bytes, equal to std::hash<std::string> of
+         * the same key, for policies that rank nodes by their keys
+         * (TreapBalance).
+         */
+        static size_t hashOf(const Node *n);
+
+        /**
+         * Whether a's key orders before b's.
+         */
+        static bool keyLess(const Node *a, const Node *b);
+
+        /**
+         * Write the key into out (replacing its contents).
+         */
+        void spell(std::string &out) const;
+    };
+
+    Node *root;
+
+    /**
+     * Scratch stack of the links walked by add() and remove(), bottom-most
+     * last, as in BST.
+     */
+    std::vector<Node **> path;
+
+    Allocator<Node> alloc;
+
+    /**
+     * Storage for the bytes of every key past its first INLINE.
+     */
+    KeyArena arena;
+
+    /**
+     * The first INLINE bytes of key as an integer that orders like the
+     * bytes do (bytes past the end count as 0).
+     */
+    static uint64_t prefixOf(const char *key, size_t length);
+
+    /**
+     * Three-way comparison of probe against n's key, like
+     * std::string::compare.
+     */
+    static int compare(const Probe &probe, const Node *n);
+
+    /**
+     * New node holding a copy of key.
+     */
+    Node *makeNode(std::string_view key);
+
+    /**
+     * Give the arena bytes of n's tail back (they are reclaimed by the
+     * next compaction).
+     */
+    void releaseTail(const Node *n);
+
+    /**
+     * Copy every live tail into a fresh arena and drop the old one, if
+     * released bytes have come to outweigh the live ones.
+     */
+    void compactIfSparse();
+
+    void rebalancePath();
+
+    template<typename ForwardIt>
+    Node *buildSorted(ForwardIt &next, int n);
+
+    /**
+     * Relink the whole tree with Balance::link, after assignSorted() built
+     * it of minimum height for a policy that needs another shape.
+     */
+    void relink();
+
+    /**
+     * Delete the whole tree and its arena and leave it empty.
+     */
+    void clearAll();
+
+    /**
+     * Deletes a subtree in O(1) extra space by rotating it into a list, as
+     * in BST.
+     */
+    void clear(Node *me);
+
+    /**
+     * Copy a subtree using an explicit stack, storing the tails into this
+     * tree's arena.
+     */
+    Node *copy(const Node *me);
+
+    /**
+     * Visits every node of the subtree under me in in-order.
+     */
+    template<typename Visit>
+    static void forEachNodeInOrder(const Node *me, Visit visit);
+};
+
+template<typename Balance, template<typename> class Allocator>
+StringBST<Balance, Allocator>::StringBST() : root(nullptr) {
+}
+
+template<typename Balance, template<typename> class Allocator>
+StringBST<Balance, Allocator>::~StringBST() {
+    clearAll();
+}
+
+template<typename Balance, template<typename> class Allocator>
+StringBST<Balance, Allocator>::StringBST(const StringBST &other) : root(nullptr) {
+    root = copy(other.root);
+}
+
+template<typename Balance, template<typename> class Allocator>
+StringBST<Balance, Allocator> &StringBST<Balance, Allocator>::operator=(const StringBST &rhs) {
+    if (this != &rhs) {
+        clearAll();
+        root = copy(rhs.root);
+    }
+    return *this;
+}
+
+template<typename Balance, template<typename> class Allocator>
+StringBST<Balance, Allocator>::StringBST(StringBST &&other) noexcept
+        : root(other.root), alloc(std::move(other.alloc)), arena(std::move(other.arena)) {
+    other.root = nullptr;
+}
+
+template<typename Balance, template<typename> class Allocator>
+StringBST<Balance, Allocator> &StringBST<Balance, Allocator>::operator=(StringBST &&rhs) noexcept {
+    if (this != &rhs) {
+        clearAll();
+        alloc = std::move(rhs.alloc);
+        arena.swap(rhs.arena);
+        root = rhs.root;
+        rhs.root = nullptr;
+    }
+    return *this;
+}
+
+template<typename Balance, template<typename> class Allocator>
+bool StringBST<Balance, Allocator>::has(std::string_view key) const {
+    Probe probe(key);
+    const Node *me = root;
+    while (me != nullptr) {
+        int c = compare(probe, me);
+        if (c < 0)
+            me = me->left;
+        else if (c > 0)
+            me = me->right;
+        else
+            return true;
+    }
+    return false;
+}
+
+template<typename Balance, template<typename> class Allocator>
+void StringBST<Balance, Allocator>::add(std::string_view newKey) {
+    Probe probe(newKey);
+    path.clear();
+    Node **link = &root;
+    while (*link != nullptr) {
+        int c = compare(probe, *link);
+        if (c == 0) {
+            path.clear();
+            return; // already an element
+        }
+        path.push_back(link);
+        link = c < 0 ? &(*link)->left : &(*link)->right;
+    }
+    *link = makeNode(newKey);
+    rebalancePath();
+}
+
+template<typename Balance, template<typename> class Allocator>
+template<typename ForwardIt>
+void StringBST<Balance, Allocator>::assignSorted(ForwardIt first, ForwardIt last) {
+    clearAll();
+    root = buildSorted(first, static_cast<int>(std::distance(first, last)));
+    if (!Balance::minimumHeightValid)
+        relink();
+}
+
+template<typename Balance, template<typename> class Allocator>
+template<typename InputIt>
+void StringBST<Balance, Allocator>::buildFrom(InputIt first, InputIt last) {
+    std::vector<std::string_view> keys;
+    for (; first != last; ++first)
+        keys.emplace_back(*first);
+    parallelSort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    assignSorted(keys.begin(), keys.end());
+}
+
+template<typename Balance, template<typename> class Allocator>
+void StringBST<Balance, Allocator>::remove(std::string_view key) {
+    Probe probe(key);
+    Node **link = &root;
+    while (*link != nullptr) {
+        int c = compare(probe, *link);
+        if (c == 0)
+            break;
+        path.push_back(link);
+        link = c < 0 ? &(*link)->left : &(*link)->right;
+    }
+    if (*link == nullptr) {
+        path.clear();
+        return; // not an element
+    }
+
+    Node *target = *link;
+    releaseTail(target);
+    if (target->left == nullptr) {
+        *link = target->right;
+        alloc.destroy(target);
+
+    } else if (target->right == nullptr) {
+        *link = target->left;
+        alloc.destroy(target);
+
+    } else {
+        // take over my predecessor's key, tail and all, and unlink it
+        path.push_back(link);
+        Node **maxLink = &target->left;
+        while ((*maxLink)->right != nullptr) {
+            path.push_back(maxLink);
+            maxLink = &(*maxLink)->right;
+        }
+        Node *maxNode = *maxLink;
+        target->prefix = maxNode->prefix;
+        target->tail = maxNode->tail;
+        target->length = maxNode->length;
+        *maxLink = maxNode->left;
+        alloc.destroy(maxNode);
+    }
+    rebalancePath();
+    compactIfSparse();
+}
+
+template<typename Balance, template<typename> class Allocator>
+bool StringBST<Balance, Allocator>::isEmpty() const {
+    return root == nullptr;
+}
+
+template<typename Balance, template<typename> class Allocator>
+int StringBST<Balance, Allocator>::size() const {
+    return Node::countOf(root);
+}
+
+template<typename Balance, template<typename> class Allocator>
+int StringBST<Balance, Allocator>::getLeafCount() const {
+    int leaves = 0;
+    forEachNodeInOrder(root, [&leaves](const Node *n) { leaves += n->isLeaf(); });
+    return leaves;
+}
+
+template<typename Balance, template<typename> class Allocator>
+int StringBST<Balance, Allocator>::getHeight() const {
+    return Node::heightOf(root);
+}
+
+template<typename Balance, template<typename> class Allocator>
+size_t StringBST<Balance, Allocator>::arenaBytes() const {
+    return arena.liveBytes() + arena.deadBytes();
+}
+
+template<typename Balance, template<typename> class Allocator>
+std::string StringBST<Balance, Allocator>::getInOrderTraversal() const {
+    std::ostringstream ss;
+    forEachInOrder([&ss](std::string_view key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename Balance, template<typename> class Allocator>
+std::string StringBST<Balance, Allocator>::getPreOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPreOrder([&ss](std::string_view key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename Balance, template<typename> class Allocator>
+std::string StringBST<Balance, Allocator>::getPostOrderTraversal() const {
+    std::ostringstream ss;
+    forEachPostOrder([&ss](std::string_view key) { ss << key << " "; });
+    return ss.str();
+}
+
+template<typename Balance, template<typename> class Allocator>
+template<typename Visit>
+void StringBST<Balance, Allocator>::forEachInOrder(Visit visit) const {
+    std::string key;
+    forEachNodeInOrder(root, [&](const Node *n) {
+        n->spell(key);
+        visit(std::string_view(key));
+    });
+}
+
+template<typename Balance, template<typename> class Allocator>
+template<typename Visit>
+void StringBST<Balance, Allocator>::forEachPreOrder(Visit visit) const {
+    std::string key;
+    std::vector<const Node *> todo;
+    todo.reserve(Node::heightOf(root));
+    if (root != nullptr)
+        todo.push_back(root);
+    while (!todo.empty()) {
+        const Node *me = todo.back();
+        todo.pop_back();
+        me->spell(key);
+        visit(std::string_view(key));
+        if (me->right != nullptr)
+            todo.push_back(me->right);
+        if (me->left != nullptr)
+            todo.push_back(me->left);
+    }
+}
+
+template<typename Balance, template<typename> class Allocator>
+template<typename Visit>
+void StringBST<Balance, Allocator>::forEachPostOrder(Visit visit) const {
+    std::string key;
+    std::vector<const Node *> todo;
+    todo.reserve(Node::heightOf(root));
+    const Node *me = root, *lastVisited = nullptr;
+    while (me != nullptr || !todo.empty()) {
+        if (me != nullptr) {
+            todo.push_back(me);
+            me = me->left;
+        } else {
+            const Node *top = todo.back();
+            if (top->right != nullptr && top->right != lastVisited) {
+                me = top->right;
+            } else {
+                top->spell(key);
+                visit(std::string_view(key));
+                lastVisited = top;
+                todo.pop_back();
+            }
+        }
+    }
+}
+
+template<typename Balance, template<typename> class Allocator>
+void StringBST<Balance, Allocator>::Node::spell(std::string &out) const {
+    out.resize(length);
+    for (size_t i = 0; i < INLINE && i < length; i++)
+        out[i] = static_cast<char>(prefix >> (8 * (INLINE - 1 - i)));
+    if (length > INLINE)
+        std::memcpy(&out[INLINE], tail, length - INLINE);
+}
+
+template<typename Balance, template<typename> class Allocator>
+size_t StringBST<Balance, Allocator>::Node::hashOf(const Node *n) {
+    thread_local std::string key;
+    n->spell(key);
+    return std::hash<std::string>()(key);
+}
+
+template<typename Balance, template<typename> class Allocator>
+bool StringBST<Balance, Allocator>::Node::keyLess(const Node *a, const Node *b) {
+    if (a->prefix != b->prefix)
+        return a->prefix < b->prefix;
+    // as in compare(): past equal prefixes only two long keys differ
+    if (a->length > INLINE && b->length > INLINE) {
+        size_t common = std::min(a->length, b->length) - INLINE;
+        int c = std::memcmp(a->tail, b->tail, common);
+        if (c != 0)
+            return c < 0;
+    }
+    return a->length < b->length;
+}
+
+template<typename Balance, template<typename> class Allocator>
+uint64_t StringBST<Balance, Allocator>::prefixOf(const char *key, size_t length) {
+    unsigned char bytes[INLINE] = {};
+    std::memcpy(bytes, key, std::min(length, INLINE));
+    uint64_t prefix = 0;
+    for (unsigned char b : bytes)
+        prefix = prefix << 8 | b;
+    return prefix;
+}
+
+template<typename Balance, template<typename> class Allocator>
+int StringBST<Balance, Allocator>::compare(const Probe &probe, const Node *n) {
+    if (probe.prefix != n->prefix)
+        return probe.prefix < n->prefix ? -1 : 1;
+    // equal prefixes: if either key fits inline, the shorter one is a
+    // prefix of the other (the padding matched the other's bytes)
+    size_t length = probe.key.size();
+    if (length > INLINE && n->length > INLINE) {
+        size_t common = std::min<size_t>(length, n->length) - INLINE;
+        int c = std::memcmp(probe.key.data() + INLINE, n->tail, common);
+        if (c != 0)
+            return c;
+    }
+    return length < n->length ? -1 : length > n->length ? 1 : 0;
+}
+
+template<typename Balance, template<typename> class Allocator>
+typename StringBST<Balance, Allocator>::Node *StringBST<Balance, Allocator>::makeNode(std::string_view key) {
+    const char *tail = nullptr;
+    if (key.size() > INLINE)
+        tail = arena.store(key.data() + INLINE, key.size() - INLINE);
+    return alloc.create(prefixOf(key.data(), key.size()), tail, static_cast<uint32_t>(key.size()));
+}
+
+template<typename Balance, template<typename> class Allocator>
+void StringBST<Balance, Allocator>::releaseTail(const Node *n) {
+    if (n->length > INLINE)
+        arena.release(n->length - INLINE);
+}
+
+template<typename Balance, template<typename> class Allocator>
+void StringBST<Balance, Allocator>::compactIfSparse() {
+    if (arena.deadBytes() <= arena.liveBytes() || arena.deadBytes() < 64 * 1024)
+        return;
+    KeyArena fresh;
+    forEachNodeInOrder(root, [&fresh](const Node *n) {
+        if (n->length > INLINE)
+            const_cast<Node *>(n)->tail = fresh.store(n->tail, n->length - INLINE);
+    });
+    arena.swap(fresh);
+}
+
+template<typename Balance, template<typename> class Allocator>
+void StringBST<Balance, Allocator>::rebalancePath() {
+    for (size_t i = path.size(); i-- > 0;)
+        *path[i] = Balance::rebalance(*path[i]);
+    path.clear();
+}
+
+template<typename Balance, template<typename> class Allocator>
+template<typename ForwardIt>
+typename StringBST<Balance, Allocator>::Node *StringBST<Balance, Allocator>::buildSorted(ForwardIt &next, int n) {
+    if (n == 0)
+        return nullptr;
+    int leftCount = n / 2;
+    Node *left = buildSorted(next, leftCount);
+    Node *me = makeNode(std::string_view(*next));
+    ++next;
+    me->left = left;
+    me->right = buildSorted(next, n - leftCount - 1);
+    me->update();
+    return me;
+}
+
+template<typename Balance, template<typename> class Allocator>
+void StringBST<Balance, Allocator>::relink() {
+    std::vector<Node *> nodes;
+    nodes.reserve(size());
+    forEachNodeInOrder(root, [&nodes](const Node *n) { nodes.push_back(const_cast<Node *>(n)); });
+    root = Balance::link(nodes.data(), nodes.size());
+}
+
+template<typename Balance, template<typename> class Allocator>
+void StringBST<Balance, Allocator>::clearAll() {
+    if (Allocator<Node>::bulkRelease && std::is_trivially_destructible<Node>::value)
+        alloc.releaseAll();
+    else
+        clear(root);
+    root = nullptr;
+    KeyArena().swap(arena);
+}
+
+template<typename Balance, template<typename> class Allocator>
+void StringBST<Balance, Allocator>::clear(Node *me) {
+    while (me != nullptr) {
+        if (me->left != nullptr) {
+            Node *pivot = me->left;
+            me->left = pivot->right;
+            pivot->right = me;
+            me = pivot;
+        } else {
+            Node *next = me->right;
+            alloc.destroy(me);
+            me = next;
+        }
+    }
+}
+
+template<typename Balance, template<typename> class Allocator>
+typename StringBST<Balance, Allocator>::Node *StringBST<Balance, Allocator>::copy(const Node *me) {
+    Node *result = nullptr;
+    std::vector<std::pair<const Node *, Node **>> todo;
+    if (me != nullptr)
+        todo.emplace_back(me, &result);
+    while (!todo.empty()) {
+        const Node *src = todo.back().first;
+        Node **dst = todo.back().second;
+        todo.pop_back();
+
+        const char *tail = src->length > INLINE ? arena.store(src->tail, src->length - INLINE) : nullptr;
+        Node *n = alloc.create(src->prefix, tail, src->length);
+        n->height = src->height;
+        n->count = src->count;
+        *dst = n;
+        if (src->right != nullptr)
+            todo.emplace_back(src->right, &n->right);
+        if (src->left != nullptr)
+            todo.emplace_back(src->left, &n->left);
+    }
+    return result;
+}
+
+template<typename Balance, template<typename> class Allocator>
+template<typename Visit>
+void StringBST<Balance, Allocator>::forEachNodeInOrder(const Node *me, Visit visit) {
+    std::vector<const Node *> todo;
+    todo.reserve(Node::heightOf(me));
+    while (me != nullptr || !todo.empty()) {
+        while (me != nullptr) {
+            todo.push_back(me);
+            me = me->left;
+        }
+        me = todo.back();
+        todo.pop_back();
+        visit(me);
+        me = me->right;
+    }
+}
+
+#endif //PROJECT3_STRINGBST_H
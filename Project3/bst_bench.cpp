@@ -0,0 +1,1554 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <malloc.h>
+#include <sys/resource.h>
+#include "BST.h"
+#include "BTree.h"
+#include "ConcurrentBST.h"
+#include "FastParse.h"
+#include "FineGrainedBST.h"
+#include "FrozenBST.h"
+#include "MappedBST.h"
+#include "ParallelIngest.h"
+#include "PersistentBST.h"
+#include "RadixTree.h"
+#include "SplayBST.h"
+#include "StringBST.h"
+using namespace std;
+/**
+ * Benchmark driver for the BST. Unlike Project3 it reads nothing from cin,
+ * so it can be run unattended:
+ *
+ *     bst_bench [--max-size N] [--suite NAME]... [--out FILE]
+ *
+ * Every measurement becomes one record of a JSON report (stdout by
+ * default, progress goes to stderr). Latency percentiles are taken over
+ * batches of BATCH operations, so each sample is the mean of BATCH calls
+ * rather than a single call dominated by clock overhead.
+ */
+
+using Clock = chrono::steady_clock;
+
+const size_t BATCH = 16;
+
+/**
+ * One line of the report
+ */
+struct Record {
+    string suite, tree, op, dist;
+    size_t n = 0;
+    int threads = 1;
+    size_t ops = 0;
+    double nsPerOp = 0, p50 = 0, p90 = 0, p99 = 0;
+    long peakRssKb = 0;
+    string note;
+};
+
+/**
+ * Collects records and writes them out as JSON
+ */
+class Report {
+public:
+    /**
+     * @param quiet  collect records without echoing them to stderr
+     */
+    explicit Report(bool quiet = false) : quiet(quiet) {}
+
+    const vector<Record> &all() const {
+        return records;
+    }
+
+    void add(const Record &r) {
+        records.push_back(r);
+        if (!quiet)
+            cerr << r.suite << "\t" << r.tree << "\t" << r.op << "\t" << r.dist << "\tn=" << r.n
+             << "\tthreads=" << r.threads << "\t" << r.nsPerOp << " ns/op" << (r.note.empty() ? "" : "\t") << r.note << endl;
+    }
+
+    void write(ostream &out) const {
+        out << "{\n  \"benchmark\": \"bst_bench\",\n  \"batch\": " << BATCH
+            << ",\n  \"results\": [";
+        for (size_t i = 0; i < records.size(); i++) {
+            const Record &r = records[i];
+            out << (i == 0 ? "\n" : ",\n") << "    {\"suite\": \"" << r.suite
+                << "\", \"tree\": \"" << r.tree << "\", \"op\": \"" << r.op
+                << "\", \"dist\": \"" << r.dist << "\", \"n\": " << r.n
+                << ", \"threads\": " << r.threads << ", \"ops\": " << r.ops << ", \"ns_per_op\": " << r.nsPerOp
+                << ", \"ops_per_sec\": " << (r.nsPerOp > 0 ? 1e9 / r.nsPerOp : 0)
+                << ", \"p50_ns\": " << r.p50 << ", \"p90_ns\": " << r.p90
+                << ", \"p99_ns\": " << r.p99 << ", \"peak_rss_kb\": " << r.peakRssKb;
+            if (!r.note.empty())
+                out << ", \"note\": \"" << r.note << "\"";
+            out << "}";
+        }
+        out << "\n  ]\n}\n";
+    }
+
+private:
+    vector<Record> records;
+    bool quiet;
+};
+
+/**
+ * Peak resident set size of this process in KB. resetPeakRss() makes it
+ * track the peak since the last reset where the kernel allows that.
+ */
+long peakRssKb() {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line))
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return atol(line.c_str() + 6);
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+/**
+ * Bytes currently handed out by malloc (and so by operator new), or 0
+ * where the C library cannot tell.
+ */
+size_t heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+void resetPeakRss() {
+    ofstream clearRefs("/proc/self/clear_refs");
+    if (clearRefs)
+        clearRefs << "5";
+}
+
+/**
+ * Runs op(i) for i in [0, count), timing batches of BATCH calls, and
+ * fills in the timing fields of r before adding it to the report.
+ */
+template<typename Op>
+void measure(Report &report, Record r, size_t count, Op op) {
+    vector<double> samples;
+    samples.reserve(count / BATCH + 1);
+    auto total = Clock::now();
+    for (size_t i = 0; i < count;) {
+        size_t end = min(count, i + BATCH);
+        auto start = Clock::now();
+        for (size_t j = i; j < end; j++)
+            op(j);
+        samples.push_back(chrono::duration<double, nano>(Clock::now() - start).count() / (end - i));
+        i = end;
+    }
+    double ns = chrono::duration<double, nano>(Clock::now() - total).count();
+    r.ops = count;
+    r.nsPerOp = count == 0 ? 0 : ns / count;
+    if (!samples.empty()) {
+        sort(samples.begin(), samples.end());
+        auto at = [&samples](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1))]; };
+        r.p50 = at(0.50);
+        r.p90 = at(0.90);
+        r.p99 = at(0.99);
+    }
+    r.peakRssKb = peakRssKb();
+    report.add(r);
+}
+
+/**
+ * Runs op() once and records it as a single operation.
+ */
+template<typename Op>
+void measureOnce(Report &report, const Record &r, Op op) {
+    measure(report, r, 1, [&op](size_t) { op(); });
+}
+
+/**
+ * Generates n pseudo-random keys (fixed seed so runs are comparable)
+ */
+vector<int> randomInts(size_t n, unsigned seed) {
+    mt19937 gen(seed);
+    uniform_int_distribution<int> dist(0, static_cast<int>(n) * 4);
+    vector<int> keys(n);
+    for (int &k : keys)
+        k = dist(gen);
+    return keys;
+}
+
+/**
+ * Draws count ranks in [0, n) from a Zipf distribution with exponent s
+ */
+vector<size_t> zipfRanks(size_t n, size_t count, double s, unsigned seed) {
+    vector<double> cdf(n);
+    double sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += 1.0 / pow(static_cast<double>(i + 1), s);
+        cdf[i] = sum;
+    }
+    mt19937_64 gen(seed);
+    uniform_real_distribution<double> u(0, sum);
+    vector<size_t> ranks(count);
+    for (size_t &r : ranks)
+        r = min(n - 1, static_cast<size_t>(lower_bound(cdf.begin(), cdf.end(), u(gen)) - cdf.begin()));
+    return ranks;
+}
+
+/**
+ * Key distributions. Elements are always the even numbers 0, 2, ...,
+ * 2(n - 1), so odd numbers are guaranteed misses; the distribution
+ * decides the insert order and which keys the lookups ask for.
+ */
+const vector<string> DISTRIBUTIONS = {"uniform", "sorted", "reverse", "zipfian", "clustered"};
+
+struct Workload {
+    vector<int> inserts;     // every element once, in insert order
+    vector<int> hits;        // lookups of elements
+    vector<int> misses;      // lookups of non-elements
+    vector<int> removes;     // every element once, in remove order
+};
+
+Workload makeWorkload(const string &dist, size_t n, size_t probes) {
+    Workload w;
+    mt19937 gen(static_cast<unsigned>(n) * 31 + static_cast<unsigned>(dist.size()));
+    w.inserts.resize(n);
+    for (size_t i = 0; i < n; i++)
+        w.inserts[i] = static_cast<int>(2 * i);
+
+    if (dist == "uniform" || dist == "zipfian") {
+        shuffle(w.inserts.begin(), w.inserts.end(), gen);
+    } else if (dist == "reverse") {
+        reverse(w.inserts.begin(), w.inserts.end());
+    } else if (dist == "clustered") {
+        // runs of 64 ascending keys, the runs in random order
+        const size_t RUN = 64;
+        vector<size_t> runs((n + RUN - 1) / RUN);
+        for (size_t i = 0; i < runs.size(); i++)
+            runs[i] = i;
+        shuffle(runs.begin(), runs.end(), gen);
+        w.inserts.clear();
+        for (size_t run : runs)
+            for (size_t i = run * RUN; i < min(n, (run + 1) * RUN); i++)
+                w.inserts.push_back(static_cast<int>(2 * i));
+    }
+
+    w.hits.resize(probes);
+    w.misses.resize(probes);
+    if (dist == "zipfian" && probes > 0) {
+        // popular elements are asked for far more often; the popularity
+        // ranking is the (random) insert order
+        vector<size_t> ranks = zipfRanks(n, probes, 0.99, 7);
+        for (size_t i = 0; i < probes; i++) {
+            w.hits[i] = w.inserts[ranks[i]];
+            w.misses[i] = w.inserts[ranks[(i + probes / 2) % probes]] + 1;
+        }
+    } else if (probes > 0) {
+        uniform_int_distribution<size_t> pick(0, n - 1);
+        for (size_t i = 0; i < probes; i++) {
+            w.hits[i] = static_cast<int>(2 * pick(gen));
+            w.misses[i] = static_cast<int>(2 * pick(gen) + 1);
+        }
+    }
+
+    w.removes = w.inserts;
+    shuffle(w.removes.begin(), w.removes.end(), gen);
+    return w;
+}
+
+/**
+ * Key conversions so one workload drives int and string trees. String
+ * keys are zero-padded so they sort like the numbers they encode.
+ */
+int makeKey(int k, int *) {
+    return k;
+}
+
+string makeKey(int k, string *) {
+    char buf[32];
+    snprintf(buf, sizeof buf, "book-%010d", k);
+    return buf;
+}
+
+template<typename KeyType>
+vector<KeyType> makeKeys(const vector<int> &ints) {
+    vector<KeyType> keys;
+    keys.reserve(ints.size());
+    for (int k : ints)
+        keys.push_back(makeKey(k, static_cast<KeyType *>(nullptr)));
+    return keys;
+}
+
+/**
+ * The core matrix: every public BST operation for one tree type, key
+ * distribution and size.
+ */
+template<typename Tree, typename KeyType>
+void opsBench(Report &report, const string &treeName, const string &dist, size_t n) {
+    Record r;
+    r.suite = "ops";
+    r.tree = treeName;
+    r.dist = dist;
+    r.n = n;
+
+    size_t probes = min<size_t>(n, 1000000);
+    Workload w = makeWorkload(dist, n, probes);
+    vector<KeyType> inserts = makeKeys<KeyType>(w.inserts);
+    vector<KeyType> hits = makeKeys<KeyType>(w.hits);
+    vector<KeyType> misses = makeKeys<KeyType>(w.misses);
+    vector<KeyType> removes = makeKeys<KeyType>(w.removes);
+
+    resetPeakRss();
+    Tree bst;
+    r.op = "add";
+    measure(report, r, n, [&](size_t i) { bst.add(inserts[i]); });
+
+    size_t found = 0;
+    r.op = "has_hit";
+    measure(report, r, probes, [&](size_t i) { found += bst.has(hits[i]); });
+    r.op = "has_miss";
+    measure(report, r, probes, [&](size_t i) { found += bst.has(misses[i]); });
+    if (found != probes)
+        cerr << "warning: " << treeName << " " << dist << " found " << found << " of " << probes << endl;
+
+    volatile int sink = 0;
+    r.op = "getHeight";
+    measureOnce(report, r, [&] { sink = bst.getHeight(); });
+    r.op = "getLeafCount";
+    measureOnce(report, r, [&] { sink = bst.getLeafCount(); });
+    r.op = "size";
+    measureOnce(report, r, [&] { sink = bst.size(); });
+
+    size_t bytes = 0;
+    r.op = "getInOrderTraversal";
+    measureOnce(report, r, [&] { bytes += bst.getInOrderTraversal().size(); });
+    r.op = "getPreOrderTraversal";
+    measureOnce(report, r, [&] { bytes += bst.getPreOrderTraversal().size(); });
+    r.op = "getPostOrderTraversal";
+    measureOnce(report, r, [&] { bytes += bst.getPostOrderTraversal().size(); });
+    r.op = "forEachInOrder";
+    measureOnce(report, r, [&] { bst.forEachInOrder([&bytes](const KeyType &) { ++bytes; }); });
+
+    r.op = "copy";
+    measureOnce(report, r, [&] {
+        Tree copy(bst);
+        sink = copy.isEmpty();
+    });
+
+    r.op = "remove";
+    measure(report, r, n, [&](size_t i) { bst.remove(removes[i]); });
+    (void) sink;
+}
+
+/**
+ * Runs the core matrix. The unbalanced tree degenerates into a list on
+ * sorted and reverse input, which costs O(n^2) to build, so those cases
+ * are capped at UNBALANCED_SORTED_CAP keys. FineGrainedBST is not in it:
+ * it has only the set operations (no getHeight, getLeafCount, pre/post
+ * order or copy), so it is measured by the concurrent suites alone.
+ */
+void opsSuite(Report &report, size_t maxSize) {
+    const size_t UNBALANCED_SORTED_CAP = 10000;
+    for (size_t n = 1000; n <= maxSize; n *= 10) {
+        for (const string &dist : DISTRIBUTIONS) {
+            bool degenerate = (dist == "sorted" || dist == "reverse") && n > UNBALANCED_SORTED_CAP;
+            if (!degenerate) {
+                opsBench<BST<int>, int>(report, "BST<int>", dist, n);
+                opsBench<BST<string>, string>(report, "BST<string>", dist, n);
+            }
+            opsBench<BST<int, AVLBalance>, int>(report, "BST<int,AVL>", dist, n);
+            opsBench<BST<string, AVLBalance>, string>(report, "BST<string,AVL>", dist, n);
+            opsBench<PersistentBST<int>, int>(report, "PersistentBST<int>", dist, n);
+        }
+    }
+}
+
+/**
+ * Compares the slab allocator against plain new/delete on build,
+ * add/remove churn, copy and destruction.
+ */
+template<typename Tree, typename KeyType>
+void allocatorBench(Report &report, const string &treeName, size_t n) {
+    Record r;
+    r.suite = "allocator";
+    r.tree = treeName;
+    r.dist = "uniform";
+    r.n = n;
+    vector<KeyType> keys = makeKeys<KeyType>(randomInts(n, 1));
+    vector<KeyType> churn = makeKeys<KeyType>(randomInts(n / 2, 2));
+
+    resetPeakRss();
+    Tree *bst = new Tree;
+    r.op = "add";
+    measure(report, r, n, [&](size_t i) { bst->add(keys[i]); });
+    r.op = "churn";
+    measure(report, r, churn.size(), [&](size_t i) {
+        bst->remove(churn[i]);
+        bst->add(churn[churn.size() - 1 - i]);
+    });
+    r.op = "copy";
+    measureOnce(report, r, [&] {
+        Tree copy(*bst);
+    });
+    r.op = "destroy";
+    measureOnce(report, r, [&] { delete bst; });
+}
+
+void allocatorSuite(Report &report, size_t maxSize) {
+    for (size_t n = 10000; n <= min<size_t>(maxSize, 1000000); n *= 10) {
+        allocatorBench<BST<int, AVLBalance, NewDeleteAllocator>, int>(report, "BST<int,AVL,new/delete>", n);
+        allocatorBench<BST<int, AVLBalance, NodePool>, int>(report, "BST<int,AVL,NodePool>", n);
+        allocatorBench<BST<string, AVLBalance, NewDeleteAllocator>, string>(report, "BST<string,AVL,new/delete>", n);
+        allocatorBench<BST<string, AVLBalance, NodePool>, string>(report, "BST<string,AVL,NodePool>", n);
+    }
+}
+
+/**
+ * Times loading keys one add() at a time against buildFrom()
+ */
+void bulkLoadSuite(Report &report, size_t maxSize) {
+    size_t n = min<size_t>(maxSize, 1000000);
+    for (const char *dist : {"sorted", "uniform"}) {
+        Workload w = makeWorkload(dist, n, 0);
+        Record r;
+        r.suite = "bulkload";
+        r.tree = "BST<int,AVL>";
+        r.dist = dist;
+        r.n = n;
+
+        resetPeakRss();
+        r.op = "add_per_key";
+        measureOnce(report, r, [&] {
+            BST<int, AVLBalance> bst;
+            for (int k : w.inserts)
+                bst.add(k);
+        });
+        r.op = "buildFrom";
+        measureOnce(report, r, [&] {
+            BST<int, AVLBalance> bst;
+            bst.buildFrom(w.inserts.begin(), w.inserts.end());
+        });
+    }
+}
+
+/**
+ * Parallel ingest of an integer file: readIntFile(), buildFrom() and the
+ * two together at 1 to 16 threads. ns_per_op is per key in the file.
+ */
+void ingestSuite(Report &report, size_t maxSize) {
+    size_t n = min<size_t>(maxSize * 10, 100000000);
+    const char *path = "bst_bench_ingest.tmp";
+    {
+        vector<int> ints = randomInts(n, 3);
+        ofstream out(path);
+        for (int k : ints)
+            out << k << '\n';
+    }
+    for (unsigned threads = 1; threads <= 16; threads *= 2) {
+        Record r;
+        r.suite = "ingest";
+        r.tree = "BST<int,AVL>";
+        r.dist = "uniform";
+        r.n = n;
+        r.threads = static_cast<int>(threads);
+        auto perKey = [&](const string &op, double ns) {
+            r.op = op;
+            r.ops = n;
+            r.nsPerOp = ns / n;
+            r.peakRssKb = peakRssKb();
+            report.add(r);
+        };
+
+        resetPeakRss();
+        auto start = Clock::now();
+        vector<int> keys;
+        readIntFile(path, keys, threads);
+        auto parsed = Clock::now();
+        BST<int, AVLBalance> bst;
+        bst.buildFrom(keys.begin(), keys.end(), threads);
+        auto built = Clock::now();
+        if (keys.size() != n)
+            cerr << "warning: ingest read " << keys.size() << " of " << n << " keys" << endl;
+
+        perKey("readIntFile", chrono::duration<double, nano>(parsed - start).count());
+        perKey("buildFrom", chrono::duration<double, nano>(built - parsed).count());
+        perKey("ingest", chrono::duration<double, nano>(built - start).count());
+    }
+    std::remove(path);
+}
+
+/**
+ * Cost of a snapshot: a deep BST copy against sharing a PersistentBST,
+ * alone and followed by one add() to the copy (which has to copy a path)
+ */
+template<typename Tree>
+void snapshotBench(Report &report, const string &treeName, size_t n) {
+    const size_t SNAPSHOTS = 100;
+    Workload w = makeWorkload("uniform", n, SNAPSHOTS);
+    Tree tree;
+    for (int k : w.inserts)
+        tree.add(k);
+
+    Record r;
+    r.suite = "snapshot";
+    r.tree = treeName;
+    r.dist = "uniform";
+    r.n = n;
+    volatile int sink = 0;
+    resetPeakRss();
+    r.op = "snapshot";
+    measure(report, r, SNAPSHOTS, [&](size_t) {
+        Tree copy(tree);
+        sink = copy.size();
+    });
+    r.op = "snapshot+add";
+    measure(report, r, SNAPSHOTS, [&](size_t i) {
+        Tree copy(tree);
+        copy.add(w.misses[i]);
+        sink = copy.size();
+    });
+    (void) sink;
+}
+
+void snapshotSuite(Report &report, size_t maxSize) {
+    for (size_t n = 1000; n <= maxSize; n *= 10) {
+        snapshotBench<BST<int, AVLBalance>>(report, "BST<int,AVL>", n);
+        snapshotBench<PersistentBST<int>>(report, "PersistentBST<int>", n);
+    }
+}
+
+/**
+ * Loader parse speed: ifstream extraction against the mapped tokenizer
+ * and from_chars, for an integer file and a string file. ns_per_op is per
+ * token; the note gives the throughput in MB/s.
+ */
+void parseSuite(Report &report, size_t maxSize) {
+    size_t n = min<size_t>(maxSize * 10, 100000000);
+    const char *intPath = "bst_bench_ints.tmp", *stringPath = "bst_bench_strings.tmp";
+    size_t intBytes, stringBytes;
+    {
+        vector<int> ints = randomInts(n, 4);
+        ofstream ints_out(intPath), strings_out(stringPath);
+        for (int k : ints) {
+            ints_out << k << '\n';
+            strings_out << makeKey(k, static_cast<string *>(nullptr)) << '\n';
+        }
+        intBytes = static_cast<size_t>(ints_out.tellp());
+        stringBytes = static_cast<size_t>(strings_out.tellp());
+    }
+    Record r;
+    r.suite = "parse";
+    r.dist = "uniform";
+    r.n = n;
+    auto timed = [&](const string &tree, const string &op, size_t bytes, const function<size_t()> &run) {
+        auto start = Clock::now();
+        size_t tokens = run();
+        double ns = chrono::duration<double, nano>(Clock::now() - start).count();
+        r.tree = tree;
+        r.op = op;
+        r.ops = tokens;
+        r.nsPerOp = tokens == 0 ? 0 : ns / tokens;
+        r.peakRssKb = peakRssKb();
+        r.note = "MB/s=" + to_string(static_cast<long>(bytes / ns * 1e3));
+        report.add(r);
+        if (tokens != n)
+            cerr << "warning: " << op << " found " << tokens << " of " << n << " tokens" << endl;
+    };
+
+    timed("int", "ifstream>>", intBytes, [&] {
+        ifstream in(intPath);
+        vector<int> keys;
+        int k;
+        while (in >> k)
+            keys.push_back(k);
+        return keys.size();
+    });
+    timed("int", "parseInts", intBytes, [&] {
+        MappedFile file(intPath);
+        vector<int> keys;
+        parseInts(file.text(), keys);
+        return keys.size();
+    });
+    for (unsigned threads = 2; threads <= 16; threads *= 2) {
+        r.threads = static_cast<int>(threads);
+        timed("int", "readIntFile", intBytes, [&] {
+            vector<int> keys;
+            readIntFile(intPath, keys, threads);
+            return keys.size();
+        });
+    }
+    r.threads = 1;
+    timed("string", "ifstream>>", stringBytes, [&] {
+        ifstream in(stringPath);
+        vector<string> keys;
+        string k;
+        while (in >> k)
+            keys.push_back(k);
+        return keys.size();
+    });
+    timed("string", "forEachToken", stringBytes, [&] {
+        MappedFile file(stringPath);
+        vector<string_view> keys;
+        forEachToken(file.text(), [&keys](string_view token) { keys.push_back(token); });
+        return keys.size();
+    });
+    std::remove(intPath);
+    std::remove(stringPath);
+}
+
+/**
+ * Restart cost: saveMapped() once, then openMapped() against rebuilding the
+ * tree from its keys with buildFrom(), and has() on the mapping
+ */
+template<typename KeyType>
+void mappedBench(Report &report, const string &treeName, size_t n) {
+    const char *path = "bst_bench_mapped.tmp";
+    Workload w = makeWorkload("uniform", n, min<size_t>(n, 1000000));
+    vector<KeyType> inserts = makeKeys<KeyType>(w.inserts);
+    vector<KeyType> hits = makeKeys<KeyType>(w.hits);
+    vector<KeyType> misses = makeKeys<KeyType>(w.misses);
+    BST<KeyType, AVLBalance> bst;
+    bst.buildFrom(inserts.begin(), inserts.end());
+
+    Record r;
+    r.suite = "mapped";
+    r.tree = treeName;
+    r.dist = "uniform";
+    r.n = n;
+    r.op = "save";
+    measureOnce(report, r, [&] { saveMapped(bst, path); });
+    r.op = "rebuild";
+    measureOnce(report, r, [&] {
+        BST<KeyType, AVLBalance> copy;
+        copy.buildFrom(inserts.begin(), inserts.end());
+    });
+    MappedBST<KeyType> *mapped = nullptr;
+    r.op = "openMapped";
+    measureOnce(report, r, [&] { mapped = new MappedBST<KeyType>(openMapped<KeyType>(path)); });
+    size_t found = 0;
+    r.op = "has_hit";
+    measure(report, r, hits.size(), [&](size_t i) { found += mapped->has(hits[i]); });
+    r.op = "has_miss";
+    measure(report, r, misses.size(), [&](size_t i) { found += mapped->has(misses[i]); });
+    if (found != hits.size())
+        cerr << "warning: " << treeName << " mapped found " << found << " of " << hits.size() << endl;
+    delete mapped;
+    std::remove(path);
+}
+
+void mappedSuite(Report &report, size_t maxSize) {
+    for (size_t n = 100000; n <= maxSize; n *= 10) {
+        mappedBench<int>(report, "MappedBST<int>", n);
+        mappedBench<string>(report, "MappedBST<string>", n);
+    }
+}
+
+/**
+ * String keys shaped like the real datasets, numbered from first: book
+ * titles of a few words (many starting alike) and user handles of a word
+ * and a number. Key i is distinct from every other key.
+ */
+vector<string> makeStringKeys(const string &kind, size_t first, size_t count) {
+    static const char *const WORDS[] = {"the", "a", "silent", "river", "of", "ashes", "house", "night",
+                                        "garden", "last", "winter", "song", "stone", "city", "glass", "shadow"};
+    const size_t WORD_COUNT = sizeof WORDS / sizeof WORDS[0];
+    vector<string> keys;
+    keys.reserve(count);
+    mt19937 gen(static_cast<unsigned>(first) * 17 + static_cast<unsigned>(kind.size()));
+    for (size_t i = first; i < first + count; i++) {
+        string key;
+        if (kind == "titles") {
+            key = gen() % 2 == 0 ? "the " : "";
+            for (int w = 0, words = 2 + static_cast<int>(gen() % 3); w < words; w++)
+                key.append(WORDS[gen() % WORD_COUNT]).push_back(' ');
+            key += "vol " + to_string(i);
+        } else {
+            key = string(WORDS[gen() % WORD_COUNT]) + "_" + to_string(i);
+        }
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+/**
+ * Build, memory and has() of one string tree type. The note of the
+ * memory record gives the heap bytes the tree holds per key.
+ */
+template<typename Tree>
+void stringBench(Report &report, const string &treeName, const string &kind, const vector<string> &keys,
+                 const vector<string> &hits, const vector<string> &misses) {
+    Record r;
+    r.suite = "strings";
+    r.tree = treeName;
+    r.dist = kind;
+    r.n = keys.size();
+
+    resetPeakRss();
+    size_t before = heapInUse();
+    Tree *bst = new Tree;
+    r.op = "add";
+    measure(report, r, keys.size(), [&](size_t i) { bst->add(keys[i]); });
+    char note[64];
+    snprintf(note, sizeof note, "%.1f bytes/key", static_cast<double>(heapInUse() - before) / keys.size());
+    r.note = note;
+    r.op = "memory";
+    report.add(r);
+    r.note.clear();
+
+    size_t found = 0;
+    r.op = "has_hit";
+    measure(report, r, hits.size(), [&](size_t i) { found += bst->has(hits[i]); });
+    r.op = "has_miss";
+    measure(report, r, misses.size(), [&](size_t i) { found += bst->has(misses[i]); });
+    if (found != hits.size())
+        cerr << "warning: " << treeName << " " << kind << " found " << found << " of " << hits.size() << endl;
+    delete bst;
+
+    r.op = "buildFrom";
+    measureOnce(report, r, [&] {
+        Tree built;
+        built.buildFrom(keys.begin(), keys.end());
+    });
+}
+
+/**
+ * Keys starting with a prefix: RadixTree::countPrefix() and prefixScan()
+ * against filtering a full in-order walk of BST<string>, the only way to
+ * answer it there. The prefixes are the first two words of random keys.
+ */
+void prefixBench(Report &report, const string &kind, const vector<string> &keys) {
+    const size_t QUERIES = 1000, SCANS = 10;
+    vector<string> prefixes;
+    mt19937 gen(8);
+    for (size_t i = 0; i < QUERIES; i++) {
+        const string &k = keys[gen() % keys.size()];
+        size_t space = k.find(' ', k.find(' ') + 1);
+        prefixes.push_back(k.substr(0, space == string::npos ? k.size() / 2 : space + 1));
+    }
+    RadixTree trie;
+    trie.buildFrom(keys.begin(), keys.end());
+    BST<string, AVLBalance> bst;
+    bst.buildFrom(keys.begin(), keys.end());
+
+    Record r;
+    r.suite = "strings";
+    r.dist = kind;
+    r.n = keys.size();
+    size_t matched = 0;
+    r.tree = "RadixTree";
+    r.op = "countPrefix";
+    measure(report, r, QUERIES, [&](size_t i) { matched += trie.countPrefix(prefixes[i]); });
+    r.op = "prefixScan";
+    measure(report, r, QUERIES, [&](size_t i) { trie.prefixScan(prefixes[i], [&matched](string_view) { ++matched; }); });
+    r.tree = "BST<string,AVL>";
+    r.op = "prefix_full_scan";
+    measure(report, r, SCANS, [&](size_t i) {
+        const string &prefix = prefixes[i];
+        bst.forEachInOrder([&](const string &key) { matched += key.compare(0, prefix.size(), prefix) == 0; });
+    });
+    (void) matched;
+}
+
+/**
+ * BST<string> against the arena-backed StringBST and the RadixTree on
+ * title and handle keys
+ */
+void stringsSuite(Report &report, size_t maxSize) {
+    for (size_t n = 100000; n <= maxSize; n *= 10) {
+        for (const char *kind : {"titles", "handles"}) {
+            vector<string> keys = makeStringKeys(kind, 0, n);
+            shuffle(keys.begin(), keys.end(), mt19937(5));
+            size_t probes = min<size_t>(n, 1000000);
+            vector<string> hits(probes);
+            mt19937 gen(6);
+            for (string &k : hits)
+                k = keys[gen() % n];
+            vector<string> misses = makeStringKeys(kind, n, probes);
+            stringBench<BST<string, AVLBalance>>(report, "BST<string,AVL>", kind, keys, hits, misses);
+            stringBench<StringBST<AVLBalance>>(report, "StringBST<AVL>", kind, keys, hits, misses);
+            stringBench<RadixTree>(report, "RadixTree", kind, keys, hits, misses);
+            prefixBench(report, kind, keys);
+        }
+    }
+}
+
+/**
+ * Keys in a window [lo, lo + width): countRange() and forEachInRange()
+ * against parsing getInOrderTraversal(), the old way to get them. Elements
+ * are the even numbers below 2n, so a window of width w holds w / 2 keys.
+ */
+void rangeSuite(Report &report, size_t maxSize) {
+    const size_t QUERIES = 10000, FULL_SCANS = 5;
+    for (size_t n = 100000; n <= maxSize; n *= 10) {
+        Workload w = makeWorkload("uniform", n, 0);
+        BST<int, AVLBalance> bst;
+        bst.buildFrom(w.inserts.begin(), w.inserts.end());
+        for (size_t width : {size_t(20), size_t(2000), n / 5}) {
+            vector<int> starts(QUERIES);
+            mt19937 gen(static_cast<unsigned>(width));
+            for (int &lo : starts)
+                lo = static_cast<int>(gen() % (2 * n));
+            Record r;
+            r.suite = "range";
+            r.tree = "BST<int,AVL>";
+            r.dist = "uniform";
+            r.n = n;
+            r.note = "window of " + to_string(width / 2) + " keys";
+            volatile long sink = 0;
+            r.op = "countRange";
+            measure(report, r, QUERIES, [&](size_t i) {
+                sink += bst.countRange(starts[i], starts[i] + static_cast<int>(width));
+            });
+            r.op = "forEachInRange";
+            measure(report, r, QUERIES, [&](size_t i) {
+                long sum = 0;
+                bst.forEachInRange(starts[i], starts[i] + static_cast<int>(width), [&sum](int k) { sum += k; });
+                sink = sum;
+            });
+            r.op = "traversal_parse";
+            measure(report, r, FULL_SCANS, [&](size_t i) {
+                istringstream in(bst.getInOrderTraversal());
+                int k;
+                while (in >> k)
+                    if (k >= starts[i] && k < starts[i] + static_cast<int>(width))
+                        sink += k;
+            });
+            (void) sink;
+        }
+    }
+}
+
+/**
+ * Join-based unionWith/intersectWith/differenceWith against the per-key
+ * way (add() or has() for every key of the smaller set), for a set of n
+ * keys and one of m, at 1 to 8 threads. Inputs are copied outside the
+ * timed region since the operations consume them.
+ */
+void setOpsSuite(Report &report, size_t maxSize) {
+    using Tree = BST<int, AVLBalance>;
+    size_t n = maxSize;
+    vector<int> big = randomInts(n, 10);
+    Tree a;
+    a.buildFrom(big.begin(), big.end());
+    for (size_t m : {n / 1000, n / 10, n}) {
+        vector<int> small = randomInts(m, 11);
+        for (int &k : small)
+            k = static_cast<int>(k * 4 % (4 * n)); // same key range as big
+        Tree b;
+        b.buildFrom(small.begin(), small.end());
+
+        Record r;
+        r.suite = "setops";
+        r.tree = "BST<int,AVL>";
+        r.dist = "uniform";
+        r.n = n;
+        r.note = "m=" + to_string(m);
+        auto timed = [&](const string &op, unsigned threads, const function<void(Tree &, Tree &)> &run) {
+            Tree left(a), right(b);
+            auto start = Clock::now();
+            run(left, right);
+            r.op = op;
+            r.threads = static_cast<int>(threads);
+            r.ops = 1;
+            r.nsPerOp = chrono::duration<double, nano>(Clock::now() - start).count();
+            r.peakRssKb = peakRssKb();
+            report.add(r);
+        };
+        timed("union_per_key", 1, [](Tree &left, Tree &right) {
+            right.forEachInOrder([&left](int k) { left.add(k); });
+        });
+        timed("intersect_per_key", 1, [](Tree &left, Tree &right) {
+            Tree out;
+            vector<int> both;
+            right.forEachInOrder([&](int k) {
+                if (left.has(k))
+                    both.push_back(k);
+            });
+            out.assignSorted(both.begin(), both.end());
+        });
+        for (unsigned threads = 1; threads <= 8; threads *= 2) {
+            timed("unionWith", threads, [threads](Tree &left, Tree &right) {
+                left.unionWith(std::move(right), threads);
+            });
+            timed("intersectWith", threads, [threads](Tree &left, Tree &right) {
+                left.intersectWith(std::move(right), threads);
+            });
+            timed("differenceWith", threads, [threads](Tree &left, Tree &right) {
+                left.differenceWith(std::move(right), threads);
+            });
+        }
+    }
+}
+
+/**
+ * Adds, hits and removes on one tree with its operation counters, which
+ * explain the timings: comparisons and nodes visited per call, and the
+ * rebalance steps AVL spends to keep the lookups short. The counters only run
+ * in a build configured with -DBST_STATS=ON; each tree's full stats()
+ * JSON then goes to stderr. Without it the same records time the
+ * uninstrumented code, so two builds give the counting overhead.
+ */
+template<typename Tree>
+void statsBench(Report &report, const string &treeName, const string &dist, size_t n) {
+    Workload w = makeWorkload(dist, n, n);
+    Tree bst;
+    Record r;
+    r.suite = "stats";
+    r.tree = treeName;
+    r.dist = dist;
+    r.n = n;
+    // times run(i) for i in [0, count) and notes what the counters of
+    // the chosen operation type (a BSTOpStats member) moved by meanwhile
+    auto timed = [&](const string &op, size_t count, BSTOpStats BSTStats::*counts, auto run) {
+        BSTOpStats before = bst.stats().*counts;
+        Report timing(true);
+        r.op = op;
+        measure(timing, r, count, run);
+        Record done = timing.all().back();
+        BSTOpStats after = bst.stats().*counts;
+        uint64_t calls = after.calls - before.calls;
+        if (calls == 0) {
+            done.note = "counters compiled out";
+        } else {
+            ostringstream note;
+            note.precision(3);
+            note << static_cast<double>(after.comparisons - before.comparisons) / calls << " cmp/op, "
+                 << static_cast<double>(after.nodesVisited - before.nodesVisited) / calls << " nodes/op, "
+                 << after.rebalances - before.rebalances << " rebalances";
+            done.note = note.str();
+        }
+        report.add(done);
+    };
+
+    volatile bool sink = false;
+    timed("add", w.inserts.size(), &BSTStats::add, [&](size_t i) { bst.add(w.inserts[i]); });
+    timed("has_hit", w.hits.size(), &BSTStats::has, [&](size_t i) { sink = bst.has(w.hits[i]); });
+    timed("has_miss", w.misses.size(), &BSTStats::has, [&](size_t i) { sink = bst.has(w.misses[i]); });
+    timed("remove", w.removes.size() / 2, &BSTStats::remove, [&](size_t i) { bst.remove(w.removes[i]); });
+    (void) sink;
+
+    BSTStats end = bst.stats();
+    if (end.enabled)
+        cerr << treeName << " " << dist << " n=" << n << " " << end.toJson() << endl;
+}
+
+/**
+ * statsBench for the unbalanced and AVL trees on uniform and Zipfian
+ * traces, and on sorted input while the unbalanced build stays bearable.
+ */
+void statsSuite(Report &report, size_t maxSize) {
+    const size_t UNBALANCED_SORTED_CAP = 10000;
+    for (const string &dist : {string("uniform"), string("zipfian"), string("sorted")}) {
+        size_t n = dist == "sorted" ? min(maxSize, UNBALANCED_SORTED_CAP) : maxSize;
+        statsBench<BST<int>>(report, "BST<int>", dist, n);
+        statsBench<BST<int, AVLBalance>>(report, "BST<int,AVL>", dist, n);
+    }
+}
+
+/**
+ * Skewed lookups: hits and misses drawn from a Zipf distribution over the
+ * elements (exponent s), which a splay tree keeps near its root. The
+ * has() calls run twice, and the note gives the tree's height after each
+ * round, so a splay tree's reshaping shows in the numbers.
+ */
+template<typename Tree>
+void splayBench(Report &report, const string &treeName, const string &dist, double s, size_t n) {
+    const size_t PROBES = 1000000;
+    Workload w = makeWorkload("uniform", n, 0);
+    vector<size_t> ranks = dist == "uniform" ? vector<size_t>() : zipfRanks(n, PROBES, s, 7);
+    // popularity follows w.removes, a shuffle independent of the insert
+    // order, or the popular keys would be the ones a plain BST has on top
+    const vector<int> &byRank = w.removes;
+    mt19937 gen(11);
+    vector<int> hits(PROBES), misses(PROBES);
+    for (size_t i = 0; i < PROBES; i++) {
+        hits[i] = byRank[ranks.empty() ? gen() % n : ranks[i]];
+        misses[i] = byRank[ranks.empty() ? gen() % n : ranks[(i + PROBES / 2) % PROBES]] + 1;
+    }
+
+    Record r;
+    r.suite = "splay";
+    r.tree = treeName;
+    r.dist = dist;
+    r.n = n;
+    Tree bst;
+    r.op = "add";
+    measure(report, r, n, [&](size_t i) { bst.add(w.inserts[i]); });
+    size_t found = 0;
+    for (int round = 1; round <= 2; round++) {
+        Report timing(true);
+        r.op = "has_hit";
+        measure(timing, r, PROBES, [&](size_t i) { found += bst.has(hits[i]); });
+        r.op = "has_miss";
+        measure(timing, r, PROBES, [&](size_t i) { found += bst.has(misses[i]); });
+        for (Record done : timing.all()) {
+            done.note = "round " + to_string(round) + ", height " + to_string(bst.getHeight());
+            report.add(done);
+        }
+    }
+    if (found != 2 * PROBES)
+        cerr << "warning: " << treeName << " " << dist << " found " << found << " of " << 2 * PROBES << endl;
+    r.op = "remove";
+    r.note.clear();
+    measure(report, r, n, [&](size_t i) { bst.remove(w.inserts[i]); });
+}
+
+/**
+ * SplayBST against the plain and AVL trees on Zipfian traces of rising
+ * skew, and on uniform lookups where splaying only costs.
+ */
+void splaySuite(Report &report, size_t maxSize) {
+    for (size_t n = 10000; n <= maxSize; n *= 10) {
+        for (double s : {0.8, 0.99, 1.2}) {
+            ostringstream dist;
+            dist << "zipfian(" << s << ")";
+            splayBench<BST<int>>(report, "BST<int>", dist.str(), s, n);
+            splayBench<BST<int, AVLBalance>>(report, "BST<int,AVL>", dist.str(), s, n);
+            splayBench<SplayBST<int>>(report, "SplayBST<int>", dist.str(), s, n);
+        }
+        splayBench<BST<int>>(report, "BST<int>", "uniform", 0, n);
+        splayBench<BST<int, AVLBalance>>(report, "BST<int,AVL>", "uniform", 0, n);
+        splayBench<SplayBST<int>>(report, "SplayBST<int>", "uniform", 0, n);
+    }
+}
+
+/**
+ * Insert and remove throughput of one balancing policy on one insert
+ * order, with the shape the inserts leave (height and average depth), and
+ * the cost of cutting the tree at its median and joining it back. That
+ * runs on a NewDeleteAllocator copy: split() on a NodePool tree moves the
+ * upper half into a pool of its own, which is O(n) whatever the policy.
+ */
+template<typename Balance>
+void treapBench(Report &report, const string &treeName, const string &dist, size_t n) {
+    using Tree = BST<int, Balance>;
+    Workload w = makeWorkload(dist, n, min<size_t>(n, 1000000));
+    Record r;
+    r.suite = "treap";
+    r.tree = treeName;
+    r.dist = dist;
+    r.n = n;
+    Tree bst;
+    r.op = "add";
+    measure(report, r, n, [&](size_t i) { bst.add(w.inserts[i]); });
+    ostringstream shape;
+    shape.precision(3);
+    shape << "height " << bst.getHeight() << ", average depth " << bst.getAverageDepth();
+    r.note = shape.str();
+    size_t found = 0;
+    r.op = "has_hit";
+    measure(report, r, w.hits.size(), [&](size_t i) { found += bst.has(w.hits[i]); });
+    if (found != w.hits.size())
+        cerr << "warning: " << treeName << " " << dist << " found " << found << " of " << w.hits.size() << endl;
+    r.note.clear();
+    BST<int, Balance, NewDeleteAllocator> linked;
+    bst.forEachInOrder([&linked](int k) { linked.add(k); });
+    r.op = "split_join";
+    measure(report, r, 1000, [&](size_t) {
+        auto upper = linked.split(static_cast<int>(n)); // the median: elements are 0, 2, ..., 2(n - 1)
+        linked.join(std::move(upper));
+    });
+    r.op = "remove";
+    measure(report, r, n, [&](size_t i) { bst.remove(w.removes[i]); });
+}
+
+/**
+ * Heights an insert order gives: trials random permutations of the same
+ * n keys, reported as min / median / max in the note. A treap's shape
+ * depends on the keys only, so it gives one height for all of them.
+ */
+template<typename Tree>
+void heightSpread(Report &report, const string &treeName, size_t n, int trials) {
+    vector<int> keys(n);
+    for (size_t i = 0; i < n; i++)
+        keys[i] = static_cast<int>(2 * i);
+    vector<int> heights;
+    double depth = 0;
+    mt19937 gen(23);
+    for (int t = 0; t < trials; t++) {
+        shuffle(keys.begin(), keys.end(), gen);
+        Tree bst;
+        for (int k : keys)
+            bst.add(k);
+        heights.push_back(bst.getHeight());
+        depth += bst.getAverageDepth();
+    }
+    sort(heights.begin(), heights.end());
+    Record r;
+    r.suite = "treap";
+    r.tree = treeName;
+    r.op = "height_spread";
+    r.dist = "uniform";
+    r.n = n;
+    r.ops = static_cast<size_t>(trials);
+    r.peakRssKb = peakRssKb();
+    ostringstream note;
+    note.precision(3);
+    note << "height " << heights.front() << " / " << heights[heights.size() / 2] << " / " << heights.back()
+         << ", mean average depth " << depth / trials;
+    r.note = note.str();
+    report.add(r);
+}
+
+/**
+ * TreapBalance against the unbalanced tree (and AVL for reference) on
+ * random, clustered and sorted insert orders; the unbalanced tree's
+ * sorted build is O(n^2), so that case is capped.
+ */
+void treapSuite(Report &report, size_t maxSize) {
+    const size_t UNBALANCED_SORTED_CAP = 10000;
+    for (const string &dist : {string("uniform"), string("clustered"), string("sorted")}) {
+        size_t n = dist == "sorted" ? min(maxSize, UNBALANCED_SORTED_CAP) : maxSize;
+        treapBench<Unbalanced>(report, "BST<int>", dist, n);
+        treapBench<AVLBalance>(report, "BST<int,AVL>", dist, n);
+        treapBench<TreapBalance>(report, "BST<int,Treap>", dist, n);
+        if (dist == "sorted" && maxSize > n)
+            treapBench<TreapBalance>(report, "BST<int,Treap>", dist, maxSize);
+    }
+    size_t n = min<size_t>(maxSize, 100000);
+    heightSpread<BST<int>>(report, "BST<int>", n, 20);
+    heightSpread<BST<int, TreapBalance>>(report, "BST<int,Treap>", n, 20);
+}
+
+/**
+ * Runs the hit and miss probes of w against set
+ */
+template<typename Set>
+void lookupBench(Report &report, const string &treeName, const Set &set, const Workload &w) {
+    Record r;
+    r.suite = "lookup";
+    r.tree = treeName;
+    r.dist = "uniform";
+    r.n = w.inserts.size();
+    size_t found = 0;
+    r.op = "has_hit";
+    measure(report, r, w.hits.size(), [&](size_t i) { found += set.has(w.hits[i]); });
+    r.op = "has_miss";
+    measure(report, r, w.misses.size(), [&](size_t i) { found += set.has(w.misses[i]); });
+}
+
+/**
+ * Compares batches of BATCH_KEYS lookups answered by a has() loop,
+ * hasMany() and hasManySorted() (the batch sorted first, sort included
+ * in the time)
+ */
+template<typename Tree>
+void batchLookupBench(Report &report, const string &treeName, const Tree &bst, const Workload &w) {
+    const size_t BATCH_KEYS = 256;
+    vector<int> probes;
+    for (size_t i = 0; i < w.hits.size(); i++) {
+        probes.push_back(w.hits[i]);
+        probes.push_back(w.misses[i]);
+    }
+    size_t batches = probes.size() / BATCH_KEYS;
+    unique_ptr<bool[]> results(new bool[BATCH_KEYS]);
+    vector<int> sorted(BATCH_KEYS);
+
+    Record r;
+    r.suite = "batch_lookup";
+    r.tree = treeName;
+    r.dist = "uniform";
+    r.n = w.inserts.size();
+    r.note = "per key, batches of " + to_string(BATCH_KEYS);
+    auto perKey = [&](Record rec) {
+        rec.ops *= BATCH_KEYS;
+        rec.nsPerOp /= BATCH_KEYS;
+        rec.p50 /= BATCH_KEYS;
+        rec.p90 /= BATCH_KEYS;
+        rec.p99 /= BATCH_KEYS;
+        report.add(rec);
+    };
+    Report scratch(true);
+    r.op = "has_loop";
+    measure(scratch, r, batches, [&](size_t b) {
+        for (size_t i = 0; i < BATCH_KEYS; i++)
+            results[i] = bst.has(probes[b * BATCH_KEYS + i]);
+    });
+    r.op = "hasMany";
+    measure(scratch, r, batches, [&](size_t b) {
+        bst.hasMany(probes.data() + b * BATCH_KEYS, BATCH_KEYS, results.get());
+    });
+    r.op = "hasManySorted";
+    measure(scratch, r, batches, [&](size_t b) {
+        copy(probes.begin() + b * BATCH_KEYS, probes.begin() + (b + 1) * BATCH_KEYS, sorted.begin());
+        sort(sorted.begin(), sorted.end());
+        bst.hasManySorted(sorted.data(), BATCH_KEYS, results.get());
+    });
+    for (const Record &rec : scratch.all())
+        perKey(rec);
+}
+
+/**
+ * Compares has() on the pointer tree, the frozen Eytzinger array and
+ * the SIMD B-tree
+ */
+void lookupSuite(Report &report, size_t maxSize) {
+    for (size_t n = 100000; n <= maxSize; n *= 10) {
+        Workload w = makeWorkload("uniform", n, 1000000);
+        Record r;
+        r.suite = "lookup";
+        r.dist = "uniform";
+        r.n = n;
+
+        BST<int, AVLBalance> bst;
+        bst.buildFrom(w.inserts.begin(), w.inserts.end());
+        lookupBench(report, "BST<int,AVL>", bst, w);
+        batchLookupBench(report, "BST<int,AVL>", bst, w);
+
+        FrozenBST<int> *frozen = nullptr;
+        r.tree = "FrozenBST<int>";
+        r.op = "freeze";
+        measureOnce(report, r, [&] { frozen = new FrozenBST<int>(bst); });
+        lookupBench(report, "FrozenBST<int>", *frozen, w);
+        delete frozen;
+
+        IntBTree btree;
+        r.tree = "IntBTree";
+        r.op = "buildFrom";
+        r.note = IntBTree::searchKind();
+        measureOnce(report, r, [&] { btree.buildFrom(w.inserts.begin(), w.inserts.end()); });
+        lookupBench(report, "IntBTree", btree, w);
+    }
+}
+
+/**
+ * BST<int,AVL> behind one mutex: what callers had to do before
+ * ConcurrentBST, and the baseline it is measured against
+ */
+class LockedBST {
+public:
+    bool has(int key) const {
+        lock_guard<mutex> lock(m);
+        return bst.has(key);
+    }
+
+    void add(int key) {
+        lock_guard<mutex> lock(m);
+        bst.add(key);
+    }
+
+    void remove(int key) {
+        lock_guard<mutex> lock(m);
+        bst.remove(key);
+    }
+
+private:
+    mutable mutex m;
+    BST<int, AVLBalance> bst;
+};
+
+/**
+ * Small per-thread generator so the threads do not share RNG state
+ */
+struct XorShift {
+    uint64_t s;
+
+    explicit XorShift(uint64_t seed) : s(seed * 0x9E3779B97F4A7C15ull + 1) {}
+
+    uint64_t operator()() {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        return s;
+    }
+};
+
+/**
+ * Runs threads threads against set for about DURATION: each operation is
+ * a has() with probability readPercent, otherwise an add() or remove()
+ * (alternating) of a random key in [0, 2n), or with disjoint in the
+ * thread's own slice of it. The record holds the aggregate throughput,
+ * so ns_per_op is wall time over all operations.
+ */
+template<typename Set>
+void concurrentBench(Report &report, const string &suite, const string &treeName, size_t n, int threads,
+                     int readPercent, bool disjoint = false) {
+    const chrono::milliseconds DURATION(200);
+    Set set;
+    vector<int> keys(n);
+    for (size_t i = 0; i < n; i++)
+        keys[i] = static_cast<int>(2 * i);
+    shuffle(keys.begin(), keys.end(), mt19937(static_cast<unsigned>(n)));
+    for (int k : keys)
+        set.add(k);
+
+    atomic<bool> start(false), stop(false);
+    atomic<size_t> total(0), hits(0);
+    vector<thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] {
+            XorShift rng(static_cast<uint64_t>(t) + 1);
+            size_t span = disjoint ? 2 * n / threads : 2 * n;
+            size_t base = disjoint ? t * span : 0;
+            size_t ops = 0, found = 0;
+            bool adding = true;
+            while (!start.load(memory_order_acquire))
+                this_thread::yield();
+            while (!stop.load(memory_order_relaxed)) {
+                for (int i = 0; i < 64; i++, ops++) {
+                    uint64_t x = rng();
+                    int key = static_cast<int>(base + (x >> 8) % span);
+                    if (static_cast<int>(x % 100) < readPercent) {
+                        found += set.has(key);
+                    } else {
+                        if (adding)
+                            set.add(key);
+                        else
+                            set.remove(key);
+                        adding = !adding;
+                    }
+                }
+            }
+            total += ops;
+            hits += found;
+        });
+    }
+    auto begin = Clock::now();
+    start.store(true, memory_order_release);
+    this_thread::sleep_for(DURATION);
+    stop.store(true);
+    for (thread &w : workers)
+        w.join();
+    double ns = chrono::duration<double, nano>(Clock::now() - begin).count();
+
+    Record r;
+    r.suite = suite;
+    r.tree = treeName;
+    r.op = to_string(readPercent) + "/" + to_string(100 - readPercent);
+    r.dist = disjoint ? "disjoint" : "uniform";
+    r.n = n;
+    r.threads = threads;
+    r.ops = total.load();
+    r.nsPerOp = r.ops == 0 ? 0 : ns / r.ops;
+    r.peakRssKb = peakRssKb();
+    r.note = "read/write mix, aggregate throughput";
+    report.add(r);
+}
+
+/**
+ * Throughput of the lock-free-reader tree against a mutex-wrapped AVL
+ * tree for 1 to 64 threads and 90/10 and 50/50 read/write mixes
+ */
+void concurrentSuite(Report &report, size_t maxSize) {
+    size_t n = min<size_t>(maxSize, 100000);
+    for (int readPercent : {90, 50}) {
+        for (int threads = 1; threads <= 64; threads *= 2) {
+            concurrentBench<ConcurrentBST<int>>(report, "concurrent", "ConcurrentBST<int>", n, threads, readPercent);
+            concurrentBench<FineGrainedBST<int>>(report, "concurrent", "FineGrainedBST<int>", n, threads, readPercent);
+            concurrentBench<LockedBST>(report, "concurrent", "BST<int,AVL>+mutex", n, threads, readPercent);
+        }
+    }
+}
+
+/**
+ * Write scaling: 1 to 32 threads doing only add()/remove(), either each
+ * in its own key range or all over the whole range
+ */
+void writersSuite(Report &report, size_t maxSize) {
+    size_t n = min<size_t>(maxSize, 100000);
+    for (bool disjoint : {true, false}) {
+        for (int threads = 1; threads <= 32; threads *= 2) {
+            concurrentBench<FineGrainedBST<int>>(report, "writers", "FineGrainedBST<int>", n, threads, 0, disjoint);
+            concurrentBench<ConcurrentBST<int>>(report, "writers", "ConcurrentBST<int>", n, threads, 0, disjoint);
+            concurrentBench<LockedBST>(report, "writers", "BST<int,AVL>+mutex", n, threads, 0, disjoint);
+        }
+    }
+}
+
+/**
+ * Multi-threaded stress test of a concurrent set. Writers churn disjoint
+ * stripes of odd keys while readers check that the even keys, which are
+ * never touched, stay visible to has() and that in-order traversals stay
+ * strictly ascending and complete. Afterwards the set must hold exactly
+ * what the writers left in it.
+ * @return number of violations seen
+ */
+template<typename Set>
+size_t stressBench(Report &report, const string &treeName, size_t maxSize) {
+    const int WRITERS = 4, READERS = 4;
+    const chrono::milliseconds DURATION(1000);
+    int n = static_cast<int>(min<size_t>(maxSize, 20000));
+    Set set;
+    vector<int> evens;
+    for (int k = 0; k < 2 * n; k += 2)
+        evens.push_back(k);
+    shuffle(evens.begin(), evens.end(), mt19937(1));
+    for (int k : evens)
+        set.add(k);
+
+    atomic<bool> stop(false);
+    atomic<size_t> violations(0), ops(0);
+    // what each writer believes it left in its stripe
+    vector<vector<char>> present(WRITERS, vector<char>(2 * n, 0));
+    vector<thread> workers;
+    for (int w = 0; w < WRITERS; w++) {
+        workers.emplace_back([&, w] {
+            XorShift rng(static_cast<uint64_t>(w) + 100);
+            size_t done = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                // odd keys k with (k / 2) % WRITERS == w belong to writer w
+                int k = 2 * static_cast<int>((rng() % (n / WRITERS)) * WRITERS + w) + 1;
+                if (rng() & 1) {
+                    set.add(k);
+                    present[w][k] = 1;
+                } else {
+                    set.remove(k);
+                    present[w][k] = 0;
+                }
+                if (set.has(k) != (present[w][k] != 0))
+                    violations++;
+                done++;
+            }
+            ops += done;
+        });
+    }
+    for (int t = 0; t < READERS; t++) {
+        workers.emplace_back([&, t] {
+            XorShift rng(static_cast<uint64_t>(t) + 200);
+            size_t done = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                if (done % 1024 == 0) {
+                    long last = -1;
+                    int evensSeen = 0;
+                    bool ordered = true;
+                    set.forEachInOrder([&](int k) {
+                        ordered = ordered && k > last;
+                        last = k;
+                        evensSeen += k % 2 == 0;
+                    });
+                    if (!ordered || evensSeen != n)
+                        violations++;
+                }
+                if (!set.has(2 * static_cast<int>(rng() % n)))
+                    violations++;
+                done++;
+            }
+            ops += done;
+        });
+    }
+    this_thread::sleep_for(DURATION);
+    stop.store(true);
+    for (thread &w : workers)
+        w.join();
+
+    int expected = n;
+    for (int k = 1; k < 2 * n; k += 2) {
+        bool want = present[(k / 2) % WRITERS][k] != 0;
+        expected += want;
+        if (set.has(k) != want)
+            violations++;
+    }
+    long last = -1;
+    int listed = 0;
+    set.forEachInOrder([&](int k) {
+        if (k <= last)
+            violations++;
+        last = k;
+        listed++;
+    });
+    if (listed != expected || set.size() != expected)
+        violations++;
+
+    Record r;
+    r.suite = "stress";
+    r.tree = treeName;
+    r.op = "mixed";
+    r.dist = "uniform";
+    r.n = static_cast<size_t>(n);
+    r.threads = WRITERS + READERS;
+    r.ops = ops.load();
+    r.nsPerOp = r.ops == 0 ? 0 : chrono::duration<double, nano>(DURATION).count() / r.ops;
+    r.peakRssKb = peakRssKb();
+    r.note = violations == 0 ? "ok" : to_string(violations.load()) + " violations";
+    report.add(r);
+    return violations;
+}
+
+/**
+ * Stress tests both concurrent trees
+ * @return number of violations seen
+ */
+size_t stressSuite(Report &report, size_t maxSize) {
+    return stressBench<ConcurrentBST<int>>(report, "ConcurrentBST<int>", maxSize)
+           + stressBench<FineGrainedBST<int>>(report, "FineGrainedBST<int>", maxSize);
+}
+
+int main(int argc, char *argv[]) {
+    size_t maxSize = 100000;
+    vector<string> suites;
+    string outPath;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--max-size") == 0 && i + 1 < argc) {
+            maxSize = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--suite") == 0 && i + 1 < argc) {
+            suites.emplace_back(argv[++i]);
+        } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outPath = argv[++i];
+        } else {
+            cerr << "usage: " << argv[0]
+                 << " [--max-size N] [--suite ops|allocator|bulkload|ingest|parse|snapshot|mapped|strings|range|setops|stats|splay|treap|lookup|batch_lookup|concurrent|writers|stress]... [--out FILE]" << endl;
+            return 1;
+        }
+    }
+    auto wanted = [&suites](const string &name) {
+        return suites.empty() || find(suites.begin(), suites.end(), name) != suites.end();
+    };
+
+    Report report;
+    if (wanted("ops"))
+        opsSuite(report, maxSize);
+    if (wanted("allocator"))
+        allocatorSuite(report, maxSize);
+    if (wanted("bulkload"))
+        bulkLoadSuite(report, maxSize);
+    if (wanted("ingest"))
+        ingestSuite(report, maxSize);
+    if (wanted("parse"))
+        parseSuite(report, maxSize);
+    if (wanted("snapshot"))
+        snapshotSuite(report, maxSize);
+    if (wanted("mapped"))
+        mappedSuite(report, maxSize);
+    if (wanted("strings"))
+        stringsSuite(report, maxSize);
+    if (wanted("range"))
+        rangeSuite(report, maxSize);
+    if (wanted("setops"))
+        setOpsSuite(report, maxSize);
+    if (wanted("stats"))
+        statsSuite(report, maxSize);
+    if (wanted("splay"))
+        splaySuite(report, maxSize);
+    if (wanted("treap"))
+        treapSuite(report, maxSize);
+    if (wanted("lookup") || wanted("batch_lookup"))
+        lookupSuite(report, maxSize);
+    if (wanted("concurrent"))
+        concurrentSuite(report, maxSize);
+    if (wanted("writers"))
+        writersSuite(report, maxSize);
+    size_t violations = 0;
+    if (wanted("stress"))
+        violations = stressSuite(report, maxSize);
+
+    if (outPath.empty()) {
+        report.write(cout);
+    } else {
+        ofstream out(outPath);
+        report.write(out);
+    }
+    return violations == 0 ? 0 : 1;
+}
@@ -0,0 +1,339 @@
+//
+// Created by Nichlos Ho on 10/17/20.
+//
+
+/**
+ * @file bst_tests.cpp - checks run by ctest
+ *
+ * `bst_tests <name>` runs the test of that name from TESTS and exits with
+ * 1 on the first failed CHECK; CMakeLists.txt registers every name.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "BST.h"
+#include "FastParse.h"
+#include "MappedBST.h"
+#include "ParallelIngest.h"
+#include "StringBST.h"
+
+using namespace std;
+
+#define CHECK(cond) check((cond), #cond, __FILE__, __LINE__)
+
+void check(bool ok, const char *what, const char *file, int line) {
+    if (!ok) {
+        cerr << file << ":" << line << ": CHECK(" << what << ") failed" << endl;
+        exit(1);
+    }
+}
+
+vector<char> readBytes(const string &path) {
+    ifstream in(path, ios::binary);
+    return vector<char>(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+void writeBytes(const string &path, const vector<char> &bytes) {
+    ofstream out(path, ios::binary | ios::trunc);
+    out.write(bytes.data(), static_cast<streamsize>(bytes.size()));
+}
+
+template<typename T>
+void patch(vector<char> &bytes, size_t at, T value) {
+    memcpy(bytes.data() + at, &value, sizeof value);
+}
+
+/**
+ * Does opening bytes as a MappedBST<KeyType> throw std::runtime_error?
+ */
+template<typename KeyType>
+bool rejects(const vector<char> &bytes) {
+    const char *path = "bst_tests_corrupt.tmp";
+    writeBytes(path, bytes);
+    bool threw = false;
+    try {
+        openMapped<KeyType>(path);
+    } catch (const runtime_error &) {
+        threw = true;
+    }
+    remove(path);
+    return threw;
+}
+
+/**
+ * MappedBST refuses truncated files and headers or offset tables that
+ * point outside the file, and still opens intact files.
+ */
+void mappedCorrupt() {
+    const char *intPath = "bst_tests_int.tmp";
+    const char *stringPath = "bst_tests_string.tmp";
+    BST<int> ints;
+    BST<string> strings;
+    for (int k = 0; k < 1000; k++) {
+        ints.add(k * 7 % 1000);
+        strings.add("key" + to_string(k));
+    }
+    saveMapped(ints, intPath);
+    saveMapped(strings, stringPath);
+    vector<char> intFile = readBytes(intPath);
+    vector<char> stringFile = readBytes(stringPath);
+    remove(intPath);
+    remove(stringPath);
+
+    CHECK(!rejects<int>(intFile));
+    CHECK(!rejects<string>(stringFile));
+
+    // truncated, then also with the header's file size patched to match
+    auto truncations = [](vector<char> file) {
+        file.resize(file.size() - 100);
+        vector<vector<char>> cut{file};
+        patch<uint64_t>(file, offsetof(MappedHeader, fileSize), file.size());
+        cut.push_back(file);
+        return cut;
+    };
+    for (const vector<char> &file : truncations(intFile))
+        CHECK(rejects<int>(file));
+    for (const vector<char> &file : truncations(stringFile))
+        CHECK(rejects<string>(file));
+    CHECK(rejects<int>(vector<char>(intFile.begin(), intFile.begin() + sizeof(MappedHeader) / 2)));
+
+    MappedHeader header;
+    memcpy(&header, stringFile.data(), sizeof header);
+    uint64_t dataLength = stringFile.size() - header.dataOffset;
+    const uint64_t HUGE_VALUE = uint64_t(1) << 62;
+    struct Corruption {
+        size_t at;
+        uint64_t value;
+    };
+    // each is applied alone to an intact file
+    vector<Corruption> headerCorruptions = {
+            {offsetof(MappedHeader, count),        HUGE_VALUE},
+            {offsetof(MappedHeader, count),        header.count * 4},
+            {offsetof(MappedHeader, sortedOffset), HUGE_VALUE},
+            {offsetof(MappedHeader, sortedOffset), header.sortedOffset + 8},
+            {offsetof(MappedHeader, sortedOffset), 0},
+            {offsetof(MappedHeader, layoutOffset), HUGE_VALUE},
+            {offsetof(MappedHeader, layoutOffset), header.sortedOffset},
+            {offsetof(MappedHeader, dataOffset),   HUGE_VALUE},
+            {offsetof(MappedHeader, dataOffset),   header.layoutOffset},
+    };
+    for (const Corruption &c : headerCorruptions) {
+        vector<char> file = stringFile;
+        patch(file, c.at, c.value);
+        CHECK(rejects<string>(file));
+        if (c.at != offsetof(MappedHeader, dataOffset)) {
+            file = intFile;
+            patch(file, c.at, c.value);
+            CHECK(rejects<int>(file));
+        }
+    }
+
+    size_t offsets = header.sortedOffset, places = header.layoutOffset;
+    vector<Corruption> tableCorruptions = {
+            {offsets,                                 1},             // offsets[0] != 0
+            {offsets + 8 * 500,                       HUGE_VALUE},    // decreasing after 500
+            {offsets + 8 * header.count,              dataLength + 1},
+            {places + 16 * 3,                         dataLength + 1},
+            {places + 16 * 3 + 8,                     dataLength},
+    };
+    for (const Corruption &c : tableCorruptions) {
+        vector<char> file = stringFile;
+        patch(file, c.at, c.value);
+        CHECK(rejects<string>(file));
+    }
+}
+
+/**
+ * parseInts() and readIntFile() stop at the first token that is not an
+ * int, as reading with ifstream >> int does, keeping a number it starts
+ * with.
+ */
+void parseIntsStop() {
+    auto parse = [](string_view text, bool complete) {
+        vector<int> out;
+        CHECK(parseInts(text, out) == complete);
+        return out;
+    };
+    CHECK(parse(" 1 -2\n+3\t", true) == vector<int>({1, -2, 3}));
+    CHECK(parse("", true).empty());
+    CHECK(parse("1 2 x 3", false) == vector<int>({1, 2}));
+    CHECK(parse("1 12abc 3", false) == vector<int>({1, 12}));
+    CHECK(parse("1 99999999999 3", false) == vector<int>({1}));
+    CHECK(parse("+5 -6 +-7 8", false) == vector<int>({5, -6}));
+    CHECK(parse("4 + 5", false) == vector<int>({4}));
+
+    // the threaded reader drops every slice after the one that stopped
+    const char *path = "bst_tests_ints.tmp";
+    {
+        ofstream out(path);
+        for (int k = 0; k < 200000; k++)
+            out << (k == 120000 ? "oops" : to_string(k)) << "\n";
+    }
+    for (unsigned threads : {1u, 2u, 7u}) {
+        vector<int> keys;
+        CHECK(readIntFile(path, keys, threads));
+        CHECK(keys.size() == 120000);
+        CHECK(keys.front() == 0 && keys.back() == 119999);
+    }
+    remove(path);
+}
+
+/**
+ * buildFrom() from string_views, with duplicates, on one thread and on
+ * several, gives the same set as adding the keys one by one.
+ */
+void buildFromViews() {
+    vector<string> words;
+    for (int k = 0; k < 50000; k++)
+        words.push_back("w" + to_string(k * 7919 % 20000));
+    vector<string_view> views(words.begin(), words.end());
+    BST<string> expected;
+    for (const string &word : words)
+        expected.add(word);
+    for (unsigned threads : {1u, 4u}) {
+        BST<string> built;
+        built.buildFrom(views.begin(), views.end(), threads);
+        CHECK(built.size() == 20000);
+        CHECK(built.getInOrderTraversal() == expected.getInOrderTraversal());
+    }
+    BST<string> few;
+    few.buildFrom(views.begin(), views.begin() + 7);
+    CHECK(few.size() == 7 && few.getHeight() == 3);
+    BST<int> ints;
+    vector<int> keys = {5, 3, 5, 1, 3};
+    ints.buildFrom(keys.begin(), keys.end());
+    CHECK(ints.getInOrderTraversal() == "1 3 5 ");
+}
+
+/**
+ * Whether a tree, given by its pre-order traversal, is a treap under
+ * TreapBalance: no node is outranked by its parent. The pre-order of a
+ * BST determines its shape: each key is the left child of the key before
+ * it if smaller, else the right child of the last key on the stack it is
+ * larger than.
+ */
+template<typename KeyType>
+bool isTreap(const string &preOrder) {
+    auto priority = [](const KeyType &key) { return TreapBalance::priorityOfHash(hash<KeyType>()(key)); };
+    auto below = [&priority](const KeyType &parent, const KeyType &child) {
+        uint64_t p = priority(parent), c = priority(child);
+        return p > c || (p == c && parent < child);
+    };
+    istringstream in(preOrder);
+    vector<KeyType> stack;
+    KeyType key;
+    while (in >> key) {
+        const KeyType *parent = stack.empty() ? nullptr : &stack.back();
+        KeyType popped;
+        bool right = false;
+        while (!stack.empty() && stack.back() < key) {
+            popped = stack.back();
+            stack.pop_back();
+            right = true;
+        }
+        if (right)
+            parent = &popped;
+        if (parent != nullptr && !below(*parent, key))
+            return false;
+        stack.push_back(key);
+    }
+    return true;
+}
+
+/**
+ * TreapBalance keeps the heap order over add(), remove(), buildFrom() and
+ * split()/join(), for BST and StringBST alike, and StringBST<TreapBalance>
+ * has the shape of BST<string, TreapBalance>.
+ */
+void treapHeap() {
+    vector<int> ints(20000);
+    for (int k = 0; k < 20000; k++)
+        ints[k] = k;
+    shuffle(ints.begin(), ints.end(), mt19937(1));
+
+    BST<int, TreapBalance> added;
+    for (int k : ints)
+        added.add(k);
+    CHECK(isTreap<int>(added.getPreOrderTraversal()));
+    for (int i = 0; i < 10000; i++)
+        added.remove(ints[i]);
+    CHECK(added.size() == 10000);
+    CHECK(isTreap<int>(added.getPreOrderTraversal()));
+
+    BST<int, TreapBalance> built;
+    built.buildFrom(ints.begin() + 10000, ints.end());
+    CHECK(isTreap<int>(built.getPreOrderTraversal()));
+    CHECK(built.getPreOrderTraversal() == added.getPreOrderTraversal());
+
+    BST<int, TreapBalance> upper = built.split(10000);
+    CHECK(isTreap<int>(built.getPreOrderTraversal()));
+    CHECK(isTreap<int>(upper.getPreOrderTraversal()));
+    built.join(std::move(upper));
+    CHECK(built.getPreOrderTraversal() == added.getPreOrderTraversal());
+
+    vector<string> words;
+    for (int k : ints)
+        words.push_back((k % 3 == 0 ? "a-long-shared-prefix-" : "w") + to_string(k));
+    BST<string, TreapBalance> strings;
+    StringBST<TreapBalance> packed;
+    for (const string &word : words) {
+        strings.add(word);
+        packed.add(word);
+    }
+    CHECK(isTreap<string>(strings.getPreOrderTraversal()));
+    CHECK(packed.getPreOrderTraversal() == strings.getPreOrderTraversal());
+    for (int i = 0; i < 10000; i++) {
+        strings.remove(words[i]);
+        packed.remove(words[i]);
+    }
+    CHECK(isTreap<string>(strings.getPreOrderTraversal()));
+    CHECK(packed.getPreOrderTraversal() == strings.getPreOrderTraversal());
+
+    StringBST<TreapBalance> packedBuilt;
+    packedBuilt.buildFrom(words.begin() + 10000, words.end());
+    CHECK(packedBuilt.getPreOrderTraversal() == strings.getPreOrderTraversal());
+
+    // the checker itself: a tree of minimum height is not a treap
+    BST<int> plain;
+    plain.buildFrom(ints.begin(), ints.end());
+    CHECK(!isTreap<int>(plain.getPreOrderTraversal()));
+}
+
+struct Test {
+    const char *name;
+    void (*run)();
+};
+
+const Test TESTS[] = {
+        {"mapped_corrupt", mappedCorrupt},
+        {"parse_ints_stop", parseIntsStop},
+        {"build_from_views", buildFromViews},
+        {"treap_heap", treapHeap},
+};
+
+int main(int argc, char *argv[]) {
+    for (const Test &test : TESTS) {
+        if (argc == 2 && string(argv[1]) == test.name) {
+            test.run();
+            cout << test.name << ": passed" << endl;
+            return 0;
+        }
+    }
+    cerr << "usage: " << argv[0] << " <test>, one of:";
+    for (const Test &test : TESTS)
+        cerr << " " << test.name;
+    cerr << endl;
+    return 2;
+}
@@ -0,0 +1,47 @@
+# Runs the Project3 driver on the sample files twice, once with the default
+# sets and once with ARGS, and fails unless the two outputs agree.
+#
+#   cmake -DDRIVER=<Project3> -DDATA=<dir with integers.dat, strings.dat>
+#         -DARGS=<driver arguments> [-DSKIP=<regex>] -P compare_driver.cmake
+#
+# Lines matching SKIP are left out of the comparison, for sets whose shape
+# (height, leaves, pre/post-order) legitimately differs from a BST's.
+
+cmake_minimum_required(VERSION 3.17)
+
+set(input "${CMAKE_CURRENT_BINARY_DIR}/compare_driver_input.txt")
+file(WRITE "${input}" "${DATA}/integers.dat\n${DATA}/strings.dat\n")
+
+function(run_driver out)
+    execute_process(COMMAND "${DRIVER}" ${ARGN}
+                    INPUT_FILE "${input}"
+                    OUTPUT_VARIABLE text
+                    RESULT_VARIABLE status)
+    if (NOT status EQUAL 0)
+        message(FATAL_ERROR "${DRIVER} ${ARGN} exited with ${status}")
+    endif ()
+    string(REPLACE "\n" ";" lines "${text}")
+    if (SKIP)
+        list(FILTER lines EXCLUDE REGEX "${SKIP}")
+    endif ()
+    set(${out} "${lines}" PARENT_SCOPE)
+endfunction()
+
+separate_arguments(args UNIX_COMMAND "${ARGS}")
+run_driver(expected)
+run_driver(actual ${args})
+
+list(LENGTH expected expectedCount)
+list(LENGTH actual actualCount)
+if (NOT expectedCount EQUAL actualCount)
+    message(FATAL_ERROR "driver ${ARGS}: ${actualCount} lines compared, expected ${expectedCount}")
+endif ()
+math(EXPR last "${expectedCount} - 1")
+foreach (i RANGE ${last})
+    list(GET expected ${i} want)
+    list(GET actual ${i} got)
+    if (NOT want STREQUAL got)
+        message(FATAL_ERROR "driver ${ARGS} differs from the default sets:\n  expected: ${want}\n  actual:   ${got}")
+    endif ()
+endforeach ()
+message(STATUS "driver ${ARGS}: ${expectedCount} lines match")
@@ -1,7 +1,13 @@
 #include <iostream>
 #include "BST.h"
+#include "BTree.h"
+#include "FastParse.h"
+#include "ParallelIngest.h"
+#include "RadixTree.h"
+#include "StringBST.h"
 #include <string>
-#include <fstream>
+#include <string_view>
+#include <vector>
 using namespace std;
 /**
  * This is the main class for testing of the BST functionality
@@ -11,34 +17,33 @@ using namespace std;
 
 
 /**
- * This Loads the int.dat file
- * @tparam KeyType
+ * This Loads the int.dat file, adding the keys in file order so the tree
+ * has the shape the traversals below print. Like reading with
+ * ifstream >> int, loading stops at the first token that is not a number.
+ * @tparam Tree BST<int>, IntBTree or another set with the same interface
  * @param bsti BST object
  */
-template<typename KeyType>
-void loadINTFile(BST<KeyType> &bsti) {
+template<typename Tree>
+void loadINTFile(Tree &bsti) {
     char filename[256];
     cout << "Enter integer file: ";
     cin.getline(filename, 256);
     cout << endl;
-    int str;
-    ifstream infile;
-    infile.open(filename);
-    if (!infile.is_open()) {
+    vector<int> keys;
+    if (!readIntFile(filename, keys)) {
         cout << "File did not open. Try pasting the path name"
              << endl;
         exit(0);
     }
-    while (infile >> str) {
-        bsti.add(str);
-    }
+    for (int key : keys)
+        bsti.add(key);
 }
 
 /**
  * Testing the creation of the BST object
  */
-template<typename KeyType>
-void testCreate(BST<KeyType> &bsti) {
+template<typename Tree>
+void testCreate(Tree &bsti) {
     cout << "** CREATE BST **" << endl;
     cout << "Number of Nodes:\t" << bsti.size() << endl;
     cout << "Number of leaves:\t" << bsti.getLeafCount() << endl;
@@ -60,8 +65,8 @@ void header() {
 /**
  * Testing the insert functionality of int bst
  */
-template<typename KeyType>
-void testInsert(BST<KeyType> &bsti) {
+template<typename Tree>
+void testInsert(Tree &bsti) {
     cout << "** TEST INSERT **" << endl;
     cout << "Inserting in this order: 40 20 10 30 60 50 70 " << endl;
     cout << "Number of Nodes:\t" << bsti.size() << endl;
@@ -74,8 +79,8 @@ void testInsert(BST<KeyType> &bsti) {
 /**
  * Testing the traversals functionality of int bst
  */
-template<typename KeyType>
-void testTraversals(BST<KeyType> &bsti) {
+template<typename Tree>
+void testTraversals(Tree &bsti) {
     cout << "** TEST TRAVERSALS **" << endl;
     cout << "pre-order:\t" << bsti.getPreOrderTraversal() << endl;
     cout << "in-order:\t" << bsti.getInOrderTraversal() << endl;
@@ -86,8 +91,8 @@ void testTraversals(BST<KeyType> &bsti) {
 /**
  * Testing the has functionality of int bst
  */
-template<typename KeyType>
-void testHas(BST<KeyType> &bsti) {
+template<typename Tree>
+void testHas(Tree &bsti) {
     cout << "** TEST CONTAINS **" << endl;
     cout << "has(20): " << boolalpha << bsti.has(20) << endl;
     cout << "has(40): " << boolalpha << bsti.has(40) << endl;
@@ -103,8 +108,8 @@ void testHas(BST<KeyType> &bsti) {
 /**
  * Testing the remove functionality of int bst
  */
-template<typename KeyType>
-void testRemove(BST<KeyType> &bsti){
+template<typename Tree>
+void testRemove(Tree &bsti){
     cout << "** TEST REMOVE **" << endl;
     cout << "Removing in this order: 20 40 10 70 99 -2 59 43" << endl;
     int array[8] = {20,40,10,70,99,-2,59,43};
@@ -127,8 +132,8 @@ void testRemove(BST<KeyType> &bsti){
 /**
  * Testing the insert functionality of int bst (again) after the removals
  */
-template<typename KeyType>
-void testInsertAgain(BST<KeyType> &bsti){
+template<typename Tree>
+void testInsertAgain(Tree &bsti){
     cout << "** TEST INSERT (again) **" << endl;
     cout << "Inserting in this order: 20 40 10 70 99 -2 59 43" << endl;
     int array[8] = {20,40,10,70,99,-2,59,43};
@@ -147,10 +152,12 @@ void testInsertAgain(BST<KeyType> &bsti){
 }
 /**
  * Test method to call all other test methods
+ * @tparam IntSet the int set under test, e.g. BST<int> or IntBTree
  */
+template<typename IntSet = BST<int>>
 void testIntBST() {
     header();
-    BST<int> bsti;
+    IntSet bsti;
     testCreate(bsti);
     loadINTFile(bsti);
     testInsert(bsti);
@@ -161,34 +168,33 @@ void testIntBST() {
 }
 
 /**
- * Loads the string file and add into BST
- * @tparam KeyType
+ * Loads the string file and add into BST, in file order
+ * @tparam Tree BST<string> or another string set with the same interface
  * @param bsti reference to the BST object
  */
-template<typename KeyType>
-void loadStringFile(BST<KeyType> &bsti) {
+template<typename Tree>
+void loadStringFile(Tree &bsti) {
     char filename[256];
     cout << "Enter string file: ";
     cin.getline(filename, 256);
     cout << endl;
-    string str;
-    ifstream infile;
-    infile.open(filename);
-    if (!infile.is_open()) {
+    MappedFile infile(filename);
+    if (!infile.isOpen()) {
         cout << "File did not open. Try pasting the path name"
              << endl;
         exit(0);
     }
-    while (infile >> str) {
-        bsti.add(str);
-    }
+    vector<string_view> keys;
+    forEachToken(infile.text(), [&keys](string_view token) { keys.push_back(token); });
+    for (string_view key : keys)
+        bsti.add(string(key));
 }
 
 /**
  * Testing the insert functionality of string bst
  */
-template<typename KeyType>
-void testStringInsert(BST<KeyType> &bsti) {
+template<typename Tree>
+void testStringInsert(Tree &bsti) {
     cout << "** TEST INSERT **" << endl;
     cout << "adding in this order: mary gene bea jen sue pat uma " << endl;
     cout << "Number of Nodes:\t" << bsti.size() << endl;
@@ -201,8 +207,8 @@ void testStringInsert(BST<KeyType> &bsti) {
 /**
  * Testing the traversals functionality of string bst
  */
-template<typename KeyType>
-void testStringTraversals(BST<KeyType> &bsti) {
+template<typename Tree>
+void testStringTraversals(Tree &bsti) {
     cout << "** TEST TRAVERSALS **\n" << endl;
     cout << "pre-order:\t" << bsti.getPreOrderTraversal() << endl;
     cout << "in-order:\t" << bsti.getInOrderTraversal() << endl;
@@ -213,8 +219,8 @@ void testStringTraversals(BST<KeyType> &bsti) {
 /**
  * Testing the has functionality of string bst
  */
-template<typename KeyType>
-void testStringHas(BST<KeyType> &bsti) {
+template<typename Tree>
+void testStringHas(Tree &bsti) {
     cout << "** TEST CONTAINS **" << endl;
     cout << "has(gene): " << boolalpha << bsti.has("gene") << endl;
     cout << "has(mary): " << boolalpha << bsti.has("mary") << endl;
@@ -230,8 +236,8 @@ void testStringHas(BST<KeyType> &bsti) {
 /**
  * Testing the remove functionality of string bst
  */
-template<typename KeyType>
-void testStringRemove(BST<KeyType> &bsti){
+template<typename Tree>
+void testStringRemove(Tree &bsti){
     cout << "** TEST REMOVE **" << endl;
     cout << "Removing in this order: gene mary bea uma yan amy ron opal" << endl;
     string array[8] = {"gene", "mary", "bea", "uma", "yan", "amy", "ron", "opal"};
@@ -254,8 +260,8 @@ void testStringRemove(BST<KeyType> &bsti){
 /**
  * Testing the insert functionality of string bst (again)
  */
-template<typename KeyType>
-void testStringInsertAgain(BST<KeyType> &bsti){
+template<typename Tree>
+void testStringInsertAgain(Tree &bsti){
     cout << "** TEST INSERT (again) **" << endl;
     cout << "Inserting in this order: gene mary bea uma yan amy ron opal" << endl;
     string array[8] = {"gene", "mary", "bea", "uma", "yan", "amy", "ron", "opal"};
@@ -275,12 +281,14 @@ void testStringInsertAgain(BST<KeyType> &bsti){
 
 /**
  * test method to call all other test methods
+ * @tparam StringSet the string set under test, e.g. BST<string> or StringBST<>
  */
+template<typename StringSet = BST<string>>
 void testStringBST(){
     cout << "********************\n"
             "* test string BST  *\n"
             "********************" << endl;
-    BST<string> bsti;
+    StringSet bsti;
     testCreate(bsti);
     cout << endl;
     loadStringFile(bsti);
@@ -295,10 +303,34 @@ void testStringBST(){
 
 /**
  * main method to call and print results of test methods
- * @return 0
+ *
+ * Usage: Project3 [int-set [string-set]]
+ * int-set picks the set testIntBST runs on: bst (BST<int>, the default)
+ * or btree (IntBTree); string-set the one testStringBST runs on: bst
+ * (BST<string>, the default), stringbst (StringBST<>) or radix
+ * (RadixTree). IntBTree and RadixTree hold the same sets but are not
+ * binary trees, so their heights, leaf counts and pre/post-orders differ
+ * from a BST's.
+ * @return 0, or 1 for an unknown set name
  */
-int main() {
-    testIntBST();
-    testStringBST();
+int main(int argc, char *argv[]) {
+    string intSet = argc > 1 ? argv[1] : "bst";
+    string stringSet = argc > 2 ? argv[2] : "bst";
+    bool knownInt = intSet == "bst" || intSet == "btree";
+    bool knownString = stringSet == "bst" || stringSet == "stringbst" || stringSet == "radix";
+    if (!knownInt || !knownString) {
+        cerr << "usage: " << argv[0] << " [bst|btree [bst|stringbst|radix]]" << endl;
+        return 1;
+    }
+    if (intSet == "bst")
+        testIntBST();
+    else
+        testIntBST<IntBTree>();
+    if (stringSet == "bst")
+        testStringBST();
+    else if (stringSet == "stringbst")
+        testStringBST<StringBST<>>();
+    else
+        testStringBST<RadixTree>();
     return 0;
 }